@@ -0,0 +1,269 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <queue>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+using i64 = long long;
+
+const i64 INF = 1e18;  // INF = 1e18, not 2^63-1 to avoid overflow
+
+// Goldberg-Tarjan cost-scaling push-relabel. Same interface as
+// MinCostMaxFlow, but the running time does not grow with the total flow:
+// O(V^2 * E * log(VC)), and far fewer passes in practice.
+//
+// mcmf(s, t) first finds the max flow value with Dinic, then repeatedly
+// refines that flow into an eps-optimal one while eps shrinks by ALPHA.
+// Costs are scaled by (V + 1) so that eps = 1 at the end means optimal.
+// Each refine resets the potentials from distances to the deficits at the
+// start and after every V relabels, without which deep, path-like graphs
+// take quadratic time.
+class CostScalingMCMF {
+ private:
+  static constexpr i64 ALPHA = 16;
+
+  int V;
+  std::vector<std::tuple<int, i64, i64, i64>> EL;  // v, cap, flow, cost
+  std::vector<std::vector<int>> AL;
+  std::vector<int> d;
+  std::vector<int> last;
+  std::vector<int> path;  // EL indices of the edges on the current s-u path
+  std::vector<i64> pot;
+  std::vector<i64> excess;
+
+  bool BFS(int s, int t) {
+    d.assign(V, -1);
+    d[s] = 0;
+    std::queue<int> q({s});
+    while (!q.empty()) {
+      int u = q.front();
+      q.pop();
+      for (auto& idx : AL[u]) {
+        auto& [v, cap, flow, cost] = EL[idx];
+        if ((cap - flow > 0) && (d[v] == -1)) {
+          d[v] = d[u] + 1, q.push(v);
+        }
+      }
+    }
+    return d[t] != -1;
+  }
+
+  // Dinic's DFS with an explicit stack, as in MaxFlow, so long layer graphs
+  // cannot overflow the call stack. path holds EL indices, and the tail of
+  // EL[idx] is the head of EL[idx ^ 1].
+  i64 blockingFlow(int s, int t) {
+    i64 total = 0;
+    path.clear();
+    int u = s;
+    while (true) {
+      if (u == t) {
+        i64 f = INF;
+        for (int idx : path) {
+          f = std::min(f, std::get<1>(EL[idx]) - std::get<2>(EL[idx]));
+        }
+        int cut = -1;
+        for (int i = 0; i < static_cast<int>(path.size()); ++i) {
+          push(path[i], f);
+          auto& [v, cap, flow, cost] = EL[path[i]];
+          if (cut == -1 && cap == flow) {
+            cut = i;
+          }
+        }
+        total += f;
+        u = std::get<0>(EL[path[cut] ^ 1]);  // tail of the first saturated edge
+        path.resize(cut);
+        continue;
+      }
+
+      int& i = last[u];  // from last edge
+      while (i < static_cast<int>(AL[u].size())) {
+        auto& [v, cap, flow, cost] = EL[AL[u][i]];
+        if (cap - flow > 0 && d[v] == d[u] + 1) {
+          break;
+        }
+        ++i;  // not part of layer graph
+      }
+      if (i < static_cast<int>(AL[u].size())) {
+        path.push_back(AL[u][i]);
+        u = std::get<0>(EL[AL[u][i]]);
+      } else if (u == s) {
+        return total;
+      } else {  // dead end, retreat and skip the edge that led here
+        u = std::get<0>(EL[path.back() ^ 1]);
+        path.pop_back();
+        ++last[u];
+      }
+    }
+  }
+
+  void push(int idx, i64 f) {
+    std::get<2>(EL[idx]) += f;
+    std::get<2>(EL[idx ^ 1]) -= f;
+  }
+
+  i64 reducedCost(int u, int idx) const {
+    auto& [v, cap, flow, cost] = EL[idx];
+    return cost + pot[u] - pot[v];
+  }
+
+  // Turn the current (balanced) flow into an eps-optimal one: saturate every
+  // residual edge with negative reduced cost, then push the excess this
+  // creates along admissible edges (reduced cost < 0), relabelling when stuck.
+  void refine(i64 eps) {
+    for (int u = 0; u < V; ++u) {
+      for (int idx : AL[u]) {
+        auto& [v, cap, flow, cost] = EL[idx];
+        if (cap - flow > 0 && reducedCost(u, idx) < 0) {
+          excess[u] -= cap - flow;
+          excess[v] += cap - flow;
+          push(idx, cap - flow);
+        }
+      }
+    }
+
+    std::queue<int> active;
+    for (int u = 0; u < V; ++u) {
+      if (excess[u] > 0) {
+        active.push(u);
+      }
+    }
+    globalUpdate(eps);
+    last.assign(V, 0);
+    int relabels = 0;
+    while (!active.empty()) {
+      int u = active.front();
+      active.pop();
+      while (excess[u] > 0) {  // discharge u
+        if (last[u] == static_cast<int>(AL[u].size())) {
+          relabel(u, eps);
+          last[u] = 0;
+          if (++relabels == V) {  // amortised O(E) per relabel, like BFS
+            globalUpdate(eps);
+            last.assign(V, 0);
+            relabels = 0;
+          }
+          continue;
+        }
+        int idx = AL[u][last[u]];
+        auto& [v, cap, flow, cost] = EL[idx];
+        if (cap - flow > 0 && reducedCost(u, idx) < 0) {
+          i64 f = std::min(excess[u], cap - flow);
+          if (excess[v] <= 0 && excess[v] + f > 0) {
+            active.push(v);
+          }
+          excess[u] -= f;
+          excess[v] += f;
+          push(idx, f);
+        } else {
+          ++last[u];
+        }
+      }
+    }
+  }
+
+  // Global price update. D[u] is the length of a shortest residual path from
+  // u to a node with a deficit, an edge u->v counting floor(rc / eps) + 1,
+  // which is >= 0 under eps-optimality. Lowering pot[u] by eps * D[u] keeps
+  // the flow eps-optimal and points admissible edges down those paths, so
+  // excess does not creep along long paths one relabel at a time. Dial's
+  // buckets, and every node at distance V or more is treated as V.
+  void globalUpdate(i64 eps) {
+    std::vector<int> D(V, V);
+    std::vector<std::vector<int>> bucket(V);
+    for (int u = 0; u < V; ++u) {
+      if (excess[u] < 0) {
+        D[u] = 0;
+        bucket[0].push_back(u);
+      }
+    }
+    for (int k = 0; k < V; ++k) {
+      for (std::size_t j = 0; j < bucket[k].size(); ++j) {  // may still grow
+        int v = bucket[k][j];
+        if (D[v] != k) {
+          continue;  // stale, v was reached closer later
+        }
+        for (int idx : AL[v]) {
+          int u = std::get<0>(EL[idx]);  // EL[idx ^ 1] is the edge u->v
+          auto& [w, cap, flow, cost] = EL[idx ^ 1];
+          if (cap - flow <= 0) {
+            continue;
+          }
+          i64 rc = reducedCost(u, idx ^ 1);
+          i64 len = rc < 0 ? 0 : rc / eps + 1;
+          if (len < D[u] - k) {
+            D[u] = k + static_cast<int>(len);
+            bucket[D[u]].push_back(u);
+          }
+        }
+      }
+    }
+    for (int u = 0; u < V; ++u) {
+      pot[u] -= eps * D[u];
+    }
+  }
+
+  // Lower pot[u] just enough to make its cheapest residual edge admissible.
+  // A node with excess always has one, since the flow was feasible.
+  void relabel(int u, i64 eps) {
+    i64 best = -INF;
+    for (int idx : AL[u]) {
+      auto& [v, cap, flow, cost] = EL[idx];
+      if (cap - flow > 0) {
+        best = std::max(best, pot[v] - cost);
+      }
+    }
+    pot[u] = best - eps;
+  }
+
+ public:
+  CostScalingMCMF(int initialV) : V(initialV) {
+    EL.clear();
+    AL.assign(V, std::vector<int>());
+  }
+
+  // if you are adding a bidirectional edge u<->v with weight w into your
+  // flow graph, set directed = false (default value is directed = true)
+  void add_edge(int u, int v, i64 w, i64 c, bool directed = true) {
+    if (u == v) {
+      return;  // safeguard: no self loop
+    }
+    EL.emplace_back(v, w, 0, c);     // u->v, cap w, flow 0, cost c
+    AL[u].push_back(EL.size() - 1);  // remember this index
+    EL.emplace_back(u, 0, 0, -c);    // back edge
+    AL[v].push_back(EL.size() - 1);  // remember this index
+    if (!directed) {
+      add_edge(v, u, w, c);  // add again in reverse
+    }
+  }
+
+  std::pair<i64, i64> mcmf(int s, int t) {
+    i64 mf = 0;
+    while (BFS(s, t)) {
+      last.assign(V, 0);
+      mf += blockingFlow(s, t);
+    }
+
+    i64 eps = 0;
+    for (auto& [v, cap, flow, cost] : EL) {
+      cost *= V + 1;
+      eps = std::max(eps, std::abs(cost));
+    }
+    pot.assign(V, 0);
+    excess.assign(V, 0);
+    while (eps > 1) {
+      eps = std::max<i64>(1, eps / ALPHA);
+      refine(eps);
+    }
+
+    i64 totalCost = 0;
+    for (int idx = 0; idx < static_cast<int>(EL.size()); idx += 2) {
+      auto& [v, cap, flow, cost] = EL[idx];
+      cost /= V + 1;  // restore, so a later call scales from scratch
+      std::get<3>(EL[idx ^ 1]) = -cost;
+      totalCost += flow * cost;
+    }
+    return {mf, totalCost};
+  }
+};
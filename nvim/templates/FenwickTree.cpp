@@ -1,21 +1,82 @@
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <span>
 #include <vector>
 
-template <typename T = long long>
-class FenwickTree {
+namespace fenwick {
+
+// Replay an offline batch in time order. Each maximal run of updates (or of
+// queries) is handed to applyRun (answerRun) as indices into its input, so
+// the callee may reorder the run freely for locality. On equal times the
+// update goes first. With no updates the queries are not even sorted.
+template <typename U, typename Q, typename ApplyRun, typename AnswerRun>
+void sweep(std::span<const U> updates,
+           std::span<const Q> queries,
+           ApplyRun applyRun,
+           AnswerRun answerRun) {
+  std::vector<int> u(updates.size()), q(queries.size());
+  std::iota(u.begin(), u.end(), 0);
+  std::iota(q.begin(), q.end(), 0);
+  if (updates.empty()) {
+    answerRun(std::span<int>(q));
+    return;
+  }
+  std::stable_sort(u.begin(), u.end(), [&](int a, int b) {
+    return updates[a].time < updates[b].time;
+  });
+  std::stable_sort(q.begin(), q.end(), [&](int a, int b) {
+    return queries[a].time < queries[b].time;
+  });
+
+  std::size_t i = 0, j = 0;
+  while (i < u.size() || j < q.size()) {
+    std::size_t from = i;
+    while (i < u.size() &&
+           (j == q.size() || updates[u[i]].time <= queries[q[j]].time)) {
+      ++i;
+    }
+    if (i > from) {
+      applyRun(std::span<int>(u).subspan(from, i - from));
+    }
+    from = j;
+    while (j < q.size() &&
+           (i == u.size() || queries[q[j]].time < updates[u[i]].time)) {
+      ++j;
+    }
+    if (j > from) {
+      answerRun(std::span<int>(q).subspan(from, j - from));
+    }
+  }
+}
+
+};  // namespace fenwick
+
+template <typename T = long long, int Dims = 1>
+class FenwickTree;
+
+template <typename T>
+class FenwickTree<T, 1> {
  public:
   FenwickTree(int n) : n(n), tree(n + 1, 0) {}
 
   FenwickTree(const std::vector<T>& data) : FenwickTree(data.size()) {
-    for (int i = 1; i <= n; ++i) {
-      tree[i] += data[i - 1];
-
-      int parent = i + (i & -i);
-      if (parent <= n) {
-        tree[parent] += tree[i];
-      }
-    }
+    build(data);
   }
 
+  struct Update {
+    int time;
+    int i;
+    T diff;
+  };
+
+  struct Query {
+    int time;
+    int l, r;
+  };
+
   constexpr T prefix(int i) const {
     T sum = 0;
     for (; i > 0; i -= i & -i) {
@@ -34,7 +95,7 @@ class FenwickTree {
 
   constexpr int kthElement(T k) const {
     // Faster, O(logn) binary lifting.
-    if (k <= 0 || k > query(n)) {
+    if (k <= 0 || k > prefix(n)) {
       return -1;
     }
 
@@ -54,9 +115,294 @@ class FenwickTree {
     return idx + 1;
   }
 
+  // All n + 1 prefix sums in O(n), by undoing the O(n) build.
+  std::vector<T> prefixSums() const {
+    std::vector<T> pre(tree);
+    for (int i = static_cast<int>(n); i >= 1; --i) {
+      int parent = i + (i & -i);
+      if (parent <= static_cast<int>(n)) {
+        pre[parent] -= pre[i];  // pre[i] is still the full tree[i] here
+      }
+    }
+    for (int i = 1; i <= static_cast<int>(n); ++i) {
+      pre[i] += pre[i - 1];
+    }
+    return pre;
+  }
+
+  // Offline batch. answers[j] is query(queries[j].l, queries[j].r) after
+  // every update with time <= queries[j].time. Runs of at least n / log n
+  // operations go through an O(n) rebuild or prefixSums(), so a batch of
+  // queries alone costs O(n + q); shorter runs are sorted by index instead.
+  void batch(std::span<const Update> updates,
+             std::span<const Query> queries,
+             std::span<T> answers) {
+    int big = std::max(1, static_cast<int>(n) / (32 - __builtin_clz(n | 1)));
+    fenwick::sweep(
+        updates, queries,
+        [&](std::span<int> run) {
+          if (static_cast<int>(run.size()) >= big) {
+            std::vector<T> data = prefixSums();
+            std::adjacent_difference(data.begin(), data.end(), data.begin());
+            data.erase(data.begin());
+            for (int idx : run) {
+              data[updates[idx].i - 1] += updates[idx].diff;
+            }
+            build(data);
+            return;
+          }
+          std::sort(run.begin(), run.end(), [&](int a, int b) {
+            return updates[a].i < updates[b].i;
+          });
+          for (int idx : run) {
+            update(updates[idx].i, updates[idx].diff);
+          }
+        },
+        [&](std::span<int> run) {
+          if (static_cast<int>(run.size()) >= big) {
+            std::vector<T> pre = prefixSums();
+            for (int idx : run) {
+              answers[idx] = pre[queries[idx].r] - pre[queries[idx].l - 1];
+            }
+            return;
+          }
+          std::sort(run.begin(), run.end(), [&](int a, int b) {
+            return queries[a].r < queries[b].r;
+          });
+          for (int idx : run) {
+            answers[idx] = query(queries[idx].l, queries[idx].r);
+          }
+        });
+  }
+
  private:
   std::size_t n;
   std::vector<T> tree;
+
+  void build(const std::vector<T>& data) {
+    std::fill(tree.begin(), tree.end(), 0);
+    for (int i = 1; i <= n; ++i) {
+      tree[i] += data[i - 1];
+
+      int parent = i + (i & -i);
+      if (parent <= n) {
+        tree[parent] += tree[i];
+      }
+    }
+  }
+};
+
+// FenwickTree replacement for arrays much larger than cache. A B-ary tree of
+// in-node prefix sums, stored level by level with the root first, so the top
+// levels stay cached and each level costs one cache miss at most:
+//   - prefix() reads a single entry per level,
+//   - update() adds to a fixed run of B entries per level (vectorises),
+//   - kthElement() counts within one node per level.
+// Leaf nodes hold inclusive prefix sums of their elements; internal nodes
+// hold exclusive prefix sums of their children's totals.
+template <typename T = long long, int B = 16>
+class WideFenwickTree {
+  static_assert(B >= 2 && (B & (B - 1)) == 0, "B must be a power of two");
+
+ public:
+  WideFenwickTree(int n) : n(n) {
+    std::vector<int> sizes;  // entries per level, leaves first
+    int nodes = std::max(1, (n + B - 1) / B);
+    sizes.push_back(nodes * B);
+    while (nodes > 1) {
+      nodes = (nodes + B - 1) / B;
+      sizes.push_back(nodes * B);
+    }
+    H = sizes.size();
+    offset.resize(H);
+    int total = 0;
+    for (int h = H - 1; h >= 0; --h) {  // root level first
+      offset[h] = total;
+      total += sizes[h];
+    }
+    tree.assign(total, 0);
+  }
+
+  WideFenwickTree(const std::vector<T>& data) : WideFenwickTree(data.size()) {
+    std::vector<T> totals(data.begin(), data.end());
+    for (int h = 0; h < H; ++h) {
+      T* level = &tree[offset[h]];
+      std::vector<T> next;
+      for (int i = 0; i < static_cast<int>(totals.size()); i += B) {
+        T sum = 0;
+        for (int j = i; j < i + B; ++j) {  // padding repeats the node total
+          T x = j < static_cast<int>(totals.size()) ? totals[j] : T{0};
+          level[j] = h == 0 ? sum + x : sum;
+          sum += x;
+        }
+        next.push_back(sum);
+      }
+      totals = std::move(next);
+    }
+  }
+
+  T prefix(int i) const {
+    if (i <= 0) {
+      return 0;
+    }
+    int p = i - 1;
+    T sum = tree[offset[0] + p];
+    for (int h = 1; h < H; ++h) {
+      sum += tree[offset[h] + (p >> (h * LOG_B))];
+    }
+    return sum;
+  }
+
+  T query(int l, int r) const { return prefix(r) - prefix(l - 1); }
+
+  void update(int i, T diff) {
+    int p = i - 1;
+    add(offset[0] + (p & ~(B - 1)), p & (B - 1), diff);  // from p onwards
+    for (int h = 1; h < H; ++h) {
+      int q = p >> (h * LOG_B);
+      add(offset[h] + (q & ~(B - 1)), (q & (B - 1)) + 1, diff);  // after q
+    }
+  }
+
+  int kthElement(T k) const {
+    if (k <= 0 || k > prefix(n)) {
+      return -1;
+    }
+
+    int node = 0;
+    for (int h = H - 1; h > 0; --h) {
+      const T* entries = &tree[offset[h] + node * B];
+      int c = count(entries, k) - 1;  // entries[0] == 0 < k, so c >= 0
+      k -= entries[c];
+      node = node * B + c;
+
+      // A node spans B * sizeof(T) bytes; request all of its cache lines now
+      // so they arrive in parallel instead of one miss at a time.
+      const T* child = &tree[offset[h - 1] + node * B];
+      for (int j = 0; j < B; j += std::max<int>(1, 64 / sizeof(T))) {
+        __builtin_prefetch(child + j);
+      }
+    }
+    return node * B + count(&tree[offset[0] + node * B], k) + 1;
+  }
+
+ private:
+  static constexpr int LOG_B = __builtin_ctz(B);
+
+  int n;
+  int H;                    // number of levels
+  std::vector<int> offset;  // offset[h] = start of level h, 0 is the leaves
+  std::vector<T> tree;
+
+  // entries[j] += diff for j >= from. Fixed trip count, so it vectorises.
+  void add(int base, int from, T diff) {
+    T* entries = &tree[base];
+    for (int j = 0; j < B; ++j) {
+      entries[j] += j >= from ? diff : T{0};
+    }
+  }
+
+  // Number of entries below k. Branch-free for the same reason.
+  static int count(const T* entries, T k) {
+    int c = 0;
+    for (int j = 0; j < B; ++j) {
+      c += entries[j] < k;
+    }
+    return c;
+  }
+};
+
+// FenwickTree over the index range [1, n] for n up to 2^63, with no
+// coordinate compression. Only nodes that an update touches are stored, in
+// an open-addressing table with linear probing, so memory is O(q log n).
+// Key 0 marks an empty slot, which is free since index 0 is never a node.
+template <typename T = long long>
+class SparseFenwickTree {
+ public:
+  SparseFenwickTree(std::uint64_t n) : n(n), used(0), keys(16, 0), vals(16) {}
+
+  T prefix(std::uint64_t i) const {
+    T sum = 0;
+    for (; i > 0; i -= i & -i) {
+      if (const T* v = find(i)) {
+        sum += *v;
+      }
+    }
+    return sum;
+  }
+
+  T query(std::uint64_t l, std::uint64_t r) const {
+    return prefix(r) - prefix(l - 1);
+  }
+
+  void update(std::uint64_t i, T diff) {
+    for (; i <= n && i > 0; i += i & -i) {  // i > 0 stops a wrap at 2^64
+      insert(i) += diff;
+    }
+  }
+
+  // Number of stored nodes.
+  std::size_t size() const { return used; }
+
+ private:
+  std::uint64_t n;
+  std::size_t used;
+  std::vector<std::uint64_t> keys;
+  std::vector<T> vals;
+
+  // splitmix64 finaliser; Fenwick nodes share low bits, so mix them all in.
+  static std::uint64_t hash(std::uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+  }
+
+  const T* find(std::uint64_t key) const {
+    std::size_t mask = keys.size() - 1;
+    for (std::size_t h = hash(key) & mask;; h = (h + 1) & mask) {
+      if (keys[h] == key) {
+        return &vals[h];
+      }
+      if (keys[h] == 0) {
+        return nullptr;
+      }
+    }
+  }
+
+  T& insert(std::uint64_t key) {
+    if (2 * (used + 1) > keys.size()) {  // keep the load factor <= 1/2
+      grow();
+    }
+    std::size_t mask = keys.size() - 1;
+    std::size_t h = hash(key) & mask;
+    while (keys[h] != 0 && keys[h] != key) {
+      h = (h + 1) & mask;
+    }
+    if (keys[h] == 0) {
+      keys[h] = key;
+      vals[h] = 0;
+      ++used;
+    }
+    return vals[h];
+  }
+
+  void grow() {
+    std::vector<std::uint64_t> oldKeys(2 * keys.size(), 0);
+    std::vector<T> oldVals(2 * vals.size());
+    keys.swap(oldKeys);
+    vals.swap(oldVals);
+    std::size_t mask = keys.size() - 1;
+    for (std::size_t j = 0; j < oldKeys.size(); ++j) {
+      if (oldKeys[j] != 0) {
+        std::size_t h = hash(oldKeys[j]) & mask;
+        while (keys[h] != 0) {
+          h = (h + 1) & mask;
+        }
+        keys[h] = oldKeys[j];
+        vals[h] = oldVals[j];
+      }
+    }
+  }
 };
 
 template <typename T = long long>
@@ -73,6 +419,9 @@ class RUPQ {
 
   T query(int i) const { return purq.prefix(i); }
 
+  // query(i) for every i in [0, n], in O(n).
+  std::vector<T> values() const { return purq.prefixSums(); }
+
  private:
   FenwickTree<T> purq;
 };
@@ -80,9 +429,10 @@ class RUPQ {
 template <typename T = long long>
 class RURQ {
  public:
-  RURQ(int n) : rupq(n), purq(n) {}
+  RURQ(int n) : n(n), rupq(n), purq(n) {}
 
-  RURQ(const std::vector<T>& data) : rupq(data), purq(data) {}
+  RURQ(const std::vector<T>& data)
+      : n(static_cast<int>(data.size())), rupq(data), purq(data) {}
 
   void update(int l, int r, T diff) {
     rupq.update(l, r, diff);
@@ -91,11 +441,168 @@ class RURQ {
     purq.update(r + 1, -diff * r);
   }
 
-  T query(int i) const { return rupq.query(i) * i - purq.query(i); }
+  T query(int i) const { return rupq.query(i) * i - purq.prefix(i); }
 
   T query(int l, int r) const { return query(r) - query(l - 1); }
 
+  struct Update {
+    int time;
+    int l, r;
+    T diff;
+  };
+
+  struct Query {
+    int time;
+    int l, r;
+  };
+
+  // Offline batch, same contract as FenwickTree::batch. Long runs of queries
+  // are answered from all prefix sums materialised in O(n).
+  void batch(std::span<const Update> updates,
+             std::span<const Query> queries,
+             std::span<T> answers) {
+    int big = std::max(1, n / (32 - __builtin_clz(n | 1)));
+    fenwick::sweep(
+        updates, queries,
+        [&](std::span<int> run) {
+          std::sort(run.begin(), run.end(), [&](int a, int b) {
+            return updates[a].l < updates[b].l;
+          });
+          for (int idx : run) {
+            update(updates[idx].l, updates[idx].r, updates[idx].diff);
+          }
+        },
+        [&](std::span<int> run) {
+          if (static_cast<int>(run.size()) >= big) {
+            std::vector<T> pre = rupq.values();
+            std::vector<T> fix = purq.prefixSums();
+            for (int i = 0; i <= n; ++i) {
+              pre[i] = pre[i] * i - fix[i];
+            }
+            for (int idx : run) {
+              answers[idx] = pre[queries[idx].r] - pre[queries[idx].l - 1];
+            }
+            return;
+          }
+          std::sort(run.begin(), run.end(), [&](int a, int b) {
+            return queries[a].r < queries[b].r;
+          });
+          for (int idx : run) {
+            answers[idx] = query(queries[idx].l, queries[idx].r);
+          }
+        });
+  }
+
  private:
+  int n;
   RUPQ<T> rupq;
   FenwickTree<T> purq;
 };
+
+// Dims-dimensional FenwickTree, 1-indexed in every dimension, stored in one
+// flat row-major buffer rather than nested vectors. The per-dimension loops
+// nest through templates, so they are unrolled at compile time.
+// Point update and prefix/box query are O(log^Dims n).
+template <typename T, int Dims>
+class FenwickTree {
+  static_assert(Dims >= 2, "1D is the specialisation above");
+
+ public:
+  using Index = std::array<int, Dims>;
+
+  FenwickTree(const Index& sizes) : n(sizes) {
+    std::size_t total = 1;
+    for (int k = Dims - 1; k >= 0; --k) {
+      stride[k] = total;
+      total *= n[k] + 1;
+    }
+    tree.assign(total, 0);
+  }
+
+  // sum over the box [1, idx]
+  T prefix(const Index& idx) const { return prefix<0>(idx, 0); }
+
+  // sum over the box [lo, hi], by inclusion-exclusion over its 2^Dims corners
+  T query(const Index& lo, const Index& hi) const {
+    T sum = 0;
+    for (int mask = 0; mask < (1 << Dims); ++mask) {
+      Index corner;
+      for (int k = 0; k < Dims; ++k) {
+        corner[k] = (mask >> k & 1) ? lo[k] - 1 : hi[k];
+      }
+      T part = prefix(corner);
+      sum += __builtin_popcount(mask) & 1 ? -part : part;
+    }
+    return sum;
+  }
+
+  void update(const Index& idx, T diff) { update<0>(idx, 0, diff); }
+
+ private:
+  Index n;
+  std::array<std::size_t, Dims> stride;
+  std::vector<T> tree;
+
+  template <int K>
+  T prefix(const Index& idx, std::size_t base) const {
+    T sum = 0;
+    for (int i = idx[K]; i > 0; i -= i & -i) {
+      if constexpr (K + 1 == Dims) {
+        sum += tree[base + i];
+      } else {
+        sum += prefix<K + 1>(idx, base + i * stride[K]);
+      }
+    }
+    return sum;
+  }
+
+  template <int K>
+  void update(const Index& idx, std::size_t base, T diff) {
+    for (int i = idx[K]; i <= n[K]; i += i & -i) {
+      if constexpr (K + 1 == Dims) {
+        tree[base + i] += diff;
+      } else {
+        update<K + 1>(idx, base + i * stride[K], diff);
+      }
+    }
+  }
+};
+
+// 2D range update, range query. Adding diff to the difference array d at
+// (i, j) contributes diff * (x - i + 1) * (y - j + 1) to the prefix sum at
+// (x, y); expanding the product splits it over four trees holding
+// d, d * i, d * j and d * i * j, the 2D form of RURQ's trick.
+template <typename T = long long>
+class RURQ2D {
+ public:
+  RURQ2D(int n, int m) : d({n, m}), di({n, m}), dj({n, m}), dij({n, m}) {}
+
+  void update(int x1, int y1, int x2, int y2, T diff) {
+    corner(x1, y1, diff);
+    corner(x1, y2 + 1, -diff);
+    corner(x2 + 1, y1, -diff);
+    corner(x2 + 1, y2 + 1, diff);
+  }
+
+  // sum over [1, x] x [1, y]
+  T query(int x, int y) const {
+    return d.prefix({x, y}) * (x + 1) * (y + 1) -
+           di.prefix({x, y}) * (y + 1) - dj.prefix({x, y}) * (x + 1) +
+           dij.prefix({x, y});
+  }
+
+  T query(int x1, int y1, int x2, int y2) const {
+    return query(x2, y2) - query(x1 - 1, y2) - query(x2, y1 - 1) +
+           query(x1 - 1, y1 - 1);
+  }
+
+ private:
+  FenwickTree<T, 2> d, di, dj, dij;
+
+  void corner(int i, int j, T diff) {
+    d.update({i, j}, diff);
+    di.update({i, j}, diff * i);
+    dj.update({i, j}, diff * j);
+    dij.update({i, j}, diff * i * j);
+  }
+};
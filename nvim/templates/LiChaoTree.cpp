@@ -0,0 +1,269 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+
+using i64 = long long;
+
+const i64 INF = 1e18;  // INF = 1e18, not 2^63-1 to avoid overflow
+
+// All three structures answer min over lines a * x + b. For max, add
+// (-a, -b) and negate the answer. Lines are evaluated in __int128, so the
+// Li Chao trees take any i64 a and b as long as the minimum itself fits;
+// MonotoneCHT multiplies differences and needs |a|, |b| <= 2^62.
+namespace lichao {
+
+struct Line {
+  i64 a, b;
+
+  __int128 operator()(i64 x) const {
+    return static_cast<__int128>(a) * x + b;
+  }
+};
+
+constexpr Line NONE{0, INF};  // INF everywhere, the answer when empty
+
+};  // namespace lichao
+
+// Li Chao tree over a fixed set of query points, known up front. Each node
+// keeps the line that wins at its midpoint; the loser can only win on one
+// side, so it moves down one path. addLine and query are O(log n),
+// addSegment is O(log^2 n).
+class LiChaoTree {
+ public:
+  LiChaoTree(std::vector<i64> xs) : xs_(std::move(xs)) {
+    std::sort(xs_.begin(), xs_.end());
+    xs_.erase(std::unique(xs_.begin(), xs_.end()), xs_.end());
+    n_ = std::max<int>(1, xs_.size());
+    xs_.resize(n_);  // keep one point even when empty
+    st_.assign(4 * n_, lichao::NONE);
+  }
+
+  void addLine(i64 a, i64 b) { insert(1, 0, n_ - 1, {a, b}); }
+
+  // The line a * x + b, but only for xl <= x <= xr.
+  void addSegment(i64 a, i64 b, i64 xl, i64 xr) {
+    int l = std::lower_bound(xs_.begin(), xs_.end(), xl) - xs_.begin();
+    int r = std::upper_bound(xs_.begin(), xs_.end(), xr) - xs_.begin() - 1;
+    if (l <= r) {
+      insert(1, 0, n_ - 1, l, r, {a, b});
+    }
+  }
+
+  // x must be one of the points given to the constructor.
+  i64 query(i64 x) const {
+    int i = std::lower_bound(xs_.begin(), xs_.end(), x) - xs_.begin();
+    __int128 best = INF;
+    for (int idx = 1, L = 0, R = n_ - 1;;) {
+      best = std::min(best, st_[idx](x));
+      if (L == R) {
+        break;
+      }
+      int mid = (L + R) / 2;
+      if (i <= mid) {
+        idx = left(idx), R = mid;
+      } else {
+        idx = right(idx), L = mid + 1;
+      }
+    }
+    return static_cast<i64>(best);
+  }
+
+ private:
+  int n_;
+  std::vector<i64> xs_;
+  std::vector<lichao::Line> st_;
+
+  static int left(int i) { return i << 1; }
+  static int right(int i) { return (i << 1) + 1; }
+
+  void insert(int idx, int L, int R, lichao::Line line) {
+    while (true) {
+      int mid = (L + R) / 2;
+      lichao::Line& cur = st_[idx];
+      bool winsLeft = line(xs_[L]) < cur(xs_[L]);
+      bool winsMid = line(xs_[mid]) < cur(xs_[mid]);
+      if (winsMid) {
+        std::swap(cur, line);
+      }
+      if (L == R) {
+        return;
+      }
+      if (winsLeft != winsMid) {  // the loser still wins somewhere left
+        idx = left(idx), R = mid;
+      } else {
+        idx = right(idx), L = mid + 1;
+      }
+    }
+  }
+
+  void insert(int idx, int L, int R, int l, int r, const lichao::Line& line) {
+    if (r < L || R < l) {
+      return;
+    }
+    if (l <= L && R <= r) {
+      insert(idx, L, R, line);
+      return;
+    }
+    int mid = (L + R) / 2;
+    insert(left(idx), L, mid, l, r, line);
+    insert(right(idx), mid + 1, R, l, r, line);
+  }
+};
+
+// Li Chao tree over every integer x in [lo, hi], nodes created on demand
+// from a pool indexed by uint32_t: O(log(hi - lo)) per operation and at most
+// one new node per addLine.
+class DLiChaoTree {
+ public:
+  DLiChaoTree(i64 lo, i64 hi) : lo_(lo), hi_(hi) {
+    nodes_.push_back({lichao::NONE});  // the root, node 0
+  }
+
+  void addLine(i64 a, i64 b) { insert(0, lo_, hi_, {a, b}); }
+
+  void addSegment(i64 a, i64 b, i64 xl, i64 xr) {
+    insert(0, lo_, hi_, std::max(xl, lo_), std::min(xr, hi_), {a, b});
+  }
+
+  i64 query(i64 x) const {
+    __int128 best = INF;
+    std::uint32_t idx = 0;
+    for (i64 L = lo_, R = hi_;;) {
+      best = std::min(best, nodes_[idx].line(x));
+      i64 mid = L + (R - L) / 2;
+      if (x <= mid) {
+        idx = nodes_[idx].left, R = mid;
+      } else {
+        idx = nodes_[idx].right, L = mid + 1;
+      }
+      if (idx == 0) {
+        break;
+      }
+    }
+    return static_cast<i64>(best);
+  }
+
+  // Number of nodes allocated so far.
+  std::size_t size() const { return nodes_.size(); }
+
+ private:
+  struct Node {
+    lichao::Line line;
+    std::uint32_t left = 0, right = 0;  // 0: not created, the root is no child
+  };
+
+  i64 lo_, hi_;
+  std::vector<Node> nodes_;
+
+  std::uint32_t child(std::uint32_t idx, bool toLeft) {
+    std::uint32_t c = toLeft ? nodes_[idx].left : nodes_[idx].right;
+    if (c == 0) {
+      nodes_.push_back({lichao::NONE});
+      c = static_cast<std::uint32_t>(nodes_.size()) - 1;
+      (toLeft ? nodes_[idx].left : nodes_[idx].right) = c;
+    }
+    return c;
+  }
+
+  void insert(std::uint32_t idx, i64 L, i64 R, lichao::Line line) {
+    while (true) {
+      i64 mid = L + (R - L) / 2;
+      lichao::Line& cur = nodes_[idx].line;
+      bool winsLeft = line(L) < cur(L);
+      bool winsMid = line(mid) < cur(mid);
+      if (winsMid) {
+        std::swap(cur, line);
+      }
+      if (L == R || (line.a == 0 && line.b == INF)) {
+        return;  // nothing left to push down
+      }
+      if (winsLeft != winsMid) {
+        idx = child(idx, true), R = mid;
+      } else {
+        idx = child(idx, false), L = mid + 1;
+      }
+    }
+  }
+
+  void insert(std::uint32_t idx, i64 L, i64 R, i64 l, i64 r,
+              const lichao::Line& line) {
+    if (r < L || R < l) {
+      return;
+    }
+    if (l <= L && R <= r) {
+      insert(idx, L, R, line);
+      return;
+    }
+    i64 mid = L + (R - L) / 2;
+    if (l <= mid) {
+      insert(child(idx, true), L, mid, l, r, line);
+    }
+    if (mid < r) {
+      insert(child(idx, false), mid + 1, R, l, r, line);
+    }
+  }
+};
+
+// Convex hull trick for lines added in order of decreasing slope, kept as
+// the lower envelope in a deque. query(x) binary-searches it in O(log n);
+// queryMonotone(x), for non-decreasing x, pops lines that can no longer win
+// off the front, O(1) amortised.
+class MonotoneCHT {
+ public:
+  void addLine(i64 a, i64 b) {
+    lichao::Line line{a, b};
+    if (!hull_.empty() && hull_.back().a == a) {
+      if (hull_.back().b <= b) {
+        return;
+      }
+      hull_.pop_back();
+    }
+    while (hull_.size() >= 2 && useless(hull_[hull_.size() - 2], hull_.back(),
+                                        line)) {
+      hull_.pop_back();
+    }
+    hull_.push_back(line);
+  }
+
+  i64 query(i64 x) const {
+    if (hull_.empty()) {
+      return INF;
+    }
+    int lo = 0, hi = static_cast<int>(hull_.size()) - 1;
+    while (lo < hi) {  // the envelope is convex, find its lowest line at x
+      int mid = (lo + hi) / 2;
+      if (hull_[mid](x) <= hull_[mid + 1](x)) {
+        hi = mid;
+      } else {
+        lo = mid + 1;
+      }
+    }
+    return static_cast<i64>(hull_[lo](x));
+  }
+
+  i64 queryMonotone(i64 x) {
+    if (hull_.empty()) {
+      return INF;
+    }
+    while (hull_.size() >= 2 && hull_[0](x) >= hull_[1](x)) {
+      hull_.pop_front();
+    }
+    return static_cast<i64>(hull_[0](x));
+  }
+
+ private:
+  std::deque<lichao::Line> hull_;
+
+  // m is redundant once l and r (slopes l.a > m.a > r.a) meet at or before
+  // where l and m do. Cross-multiplied in __int128, so no division: with
+  // |a|, |b| <= 2^62 each difference is at most 2^63 and each product 2^126.
+  static bool useless(const lichao::Line& l,
+                      const lichao::Line& m,
+                      const lichao::Line& r) {
+    __int128 lb = l.b, la = l.a;
+    return (r.b - lb) * (la - m.a) <= (m.b - lb) * (la - r.a);
+  }
+};
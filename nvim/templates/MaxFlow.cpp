@@ -10,7 +10,7 @@ using i64 = long long;
 constexpr i64 INF = 1e18;
 class MaxFlow {
  public:
-  MaxFlow(int initialV) : V(initialV) {
+  MaxFlow(int initialV) : V(initialV), frozen(false) {
     EL.clear();
     AL.assign(V, std::vector<int>());
     EM.assign(V, std::unordered_map<int, int>());
@@ -20,6 +20,9 @@ class MaxFlow {
     if (u == v) {
       return;
     }
+    if (frozen) {
+      thaw();  // keeps the flow found so far
+    }
     EL.emplace_back(v, w, 0);
     AL[u].push_back(EL.size() - 1);
     EL.emplace_back(u, directed ? 0 : w, 0);
@@ -30,23 +33,55 @@ class MaxFlow {
   i64 getEdge(int u, int v) {
     if (EM[u].find(v) == EM[u].end()) {
       return -1;
-    } else {
-      return std::get<2>(EL[EM[u][v]]);
     }
+    int idx = EM[u][v];
+    if (frozen) {
+      return std::get<1>(EL[idx]) - res[slot[idx]];
+    }
+    return std::get<2>(EL[idx]);
+  }
+
+  // Freeze the builder into CSR form. dinic() calls this itself; a later
+  // addEdge() thaws the graph again.
+  void finalize() {
+    if (frozen) {
+      return;
+    }
+    int m = static_cast<int>(EL.size());
+    start.assign(V + 1, 0);
+    for (int u = 0; u < V; ++u) {
+      start[u + 1] = start[u] + static_cast<int>(AL[u].size());
+    }
+    slot.resize(m);
+    for (int u = 0; u < V; ++u) {
+      int e = start[u];
+      for (int idx : AL[u]) {
+        slot[idx] = e++;
+      }
+    }
+    to.resize(m), res.resize(m), rev.resize(m);
+    for (int idx = 0; idx < m; ++idx) {
+      auto& [v, cap, flow] = EL[idx];
+      int e = slot[idx];
+      to[e] = v;
+      res[e] = cap - flow;
+      rev[e] = slot[idx ^ 1];
+    }
+    frozen = true;
   }
 
   i64 dinic(int s, int t) {
+    finalize();
     i64 mf = 0;
     while (BFS(s, t)) {
-      last.assign(V, 0);
-      while (i64 f = DFS(s, t)) {
-        mf += f;
-      }
+      last.assign(start.begin(), start.end() - 1);
+      mf += blockingFlow(s, t);
     }
     return mf;
   }
 
   std::vector<std::vector<int>> minCut(int s) {
+    finalize();
     std::vector<bool> visited(V, false);
     std::queue<int> q;
     q.push(s);
@@ -55,11 +90,10 @@ class MaxFlow {
     while (!q.empty()) {
       int u = q.front();
       q.pop();
-      for (int idx : AL[u]) {
-        auto [v, cap, flow] = EL[idx];
-        if (!visited[v] && cap - flow > 0) {
-          visited[v] = true;
-          q.push(v);
+      for (int e = start[u]; e < start[u + 1]; ++e) {
+        if (!visited[to[e]] && res[e] > 0) {
+          visited[to[e]] = true;
+          q.push(to[e]);
         }
       }
     }
@@ -70,7 +104,7 @@ class MaxFlow {
         for (int idx : AL[u]) {
           auto [v, cap, flow] = EL[idx];
           if (!visited[v] && cap > 0) {
-            minCut.emplace_back(u, v);
+            minCut.push_back({u, v});
           }
         }
       }
@@ -80,11 +114,32 @@ class MaxFlow {
 
  private:
   int V;
+  bool frozen;
   std::vector<std::unordered_map<int, int>> EM;
+
+  // Builder. EL[i] and EL[i ^ 1] are an edge and its back edge.
   std::vector<std::tuple<int, i64, i64>> EL;
   std::vector<std::vector<int>> AL;
+
+  // CSR form, filled by finalize(). The edges out of u are the slots
+  // [start[u], start[u + 1]), stored as parallel arrays.
+  std::vector<int> start;
+  std::vector<int> to;
+  std::vector<i64> res;   // residual capacity
+  std::vector<int> rev;   // slot of the back edge
+  std::vector<int> slot;  // EL index -> CSR slot
+
   std::vector<int> d;
   std::vector<int> last;
+  std::vector<int> path;  // slots of the edges on the current s-u path
+
+  void thaw() {  // write the residuals back into EL's flows
+    for (int idx = 0; idx < static_cast<int>(EL.size()); ++idx) {
+      auto& [v, cap, flow] = EL[idx];
+      flow = cap - res[slot[idx]];
+    }
+    frozen = false;
+  }
 
   bool BFS(int s, int t) {
     d.assign(V, -1);
@@ -96,33 +151,57 @@ class MaxFlow {
       if (u == t) {
         break;
       }
-      for (auto& idx : AL[u]) {
-        auto& [v, cap, flow] = EL[idx];
-        if ((cap - flow > 0) && (d[v] == -1)) {
-          d[v] = d[u] + 1, q.push(v);
+      for (int e = start[u]; e < start[u + 1]; ++e) {
+        if ((res[e] > 0) && (d[to[e]] == -1)) {
+          d[to[e]] = d[u] + 1, q.push(to[e]);
         }
       }
     }
     return d[t] != -1;
   }
 
-  i64 DFS(int u, int t, i64 f = INF) {
-    if ((u == t) || (f == 0)) {
-      return f;
-    }
-    for (int& i = last[u]; i < static_cast<int>(AL[u].size());
-         ++i) {  // from last edge
-      auto& [v, cap, flow] = EL[AL[u][i]];
-      if (d[v] != d[u] + 1) {
-        continue;  // not part of layer graph
+  // DFS with an explicit stack, so long layer graphs cannot overflow the call
+  // stack. After each augmentation only the edges from the first saturated
+  // one onwards are popped, and the search resumes from its tail instead of
+  // restarting at s.
+  i64 blockingFlow(int s, int t) {
+    i64 total = 0;
+    path.clear();
+    int u = s;
+    while (true) {
+      if (u == t) {
+        i64 f = INF;
+        for (int e : path) {
+          f = std::min(f, res[e]);
+        }
+        int cut = -1;
+        for (int i = 0; i < static_cast<int>(path.size()); ++i) {
+          res[path[i]] -= f;
+          res[rev[path[i]]] += f;
+          if (cut == -1 && res[path[i]] == 0) {
+            cut = i;
+          }
+        }
+        total += f;
+        u = to[rev[path[cut]]];  // tail of the first saturated edge
+        path.resize(cut);
+        continue;
+      }
+
+      int& e = last[u];  // from last edge
+      while (e < start[u + 1] && (res[e] == 0 || d[to[e]] != d[u] + 1)) {
+        ++e;  // not part of layer graph
       }
-      if (i64 pushed = DFS(v, t, std::min(f, cap - flow))) {
-        flow += pushed;
-        auto& rflow = std::get<2>(EL[AL[u][i] ^ 1]);
-        rflow -= pushed;
-        return pushed;
+      if (e < start[u + 1]) {
+        path.push_back(e);
+        u = to[e];
+      } else if (u == s) {
+        return total;
+      } else {  // dead end, retreat and skip the edge that led here
+        u = to[rev[path.back()]];
+        path.pop_back();
+        ++last[u];
       }
     }
-    return 0;
   }
 };
@@ -1,5 +1,8 @@
 #include <algorithm>
+#include <functional>
 #include <queue>
+#include <tuple>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -7,15 +10,132 @@ using i64 = long long;
 constexpr int MOD = 1'000'000'007;
 
 const i64 INF = 1e18;  // INF = 1e18, not 2^63-1 to avoid overflow
+
+namespace mcmf {
+
+// Re-run SPFA (queue-based Bellman-Ford) on every phase. O(VE) per phase, but
+// tolerates negative costs without any setup.
+struct SPFA {};
+
+// Min-heaps for the Dijkstra phases. Both hand back stale entries; the caller
+// skips any (key, v) whose key no longer matches d[v].
+class BinaryHeap {
+ public:
+  void clear() { pq = {}; }
+
+  bool empty() const { return pq.empty(); }
+
+  void push(i64 key, int v) { pq.emplace(key, v); }
+
+  std::pair<i64, int> pop() {
+    auto top = pq.top();
+    pq.pop();
+    return top;
+  }
+
+ private:
+  std::priority_queue<std::pair<i64, int>,
+                      std::vector<std::pair<i64, int>>,
+                      std::greater<>>
+      pq;
+};
+
+// Radix heap for integer keys. Only valid when popped keys never decrease,
+// which holds for Dijkstra over non-negative reduced costs. Amortised
+// O(log C) per operation, and buckets are plain vectors.
+class RadixHeap {
+ public:
+  void clear() {
+    for (auto& bucket : buckets) {
+      bucket.clear();
+    }
+    last = 0;
+    size = 0;
+  }
+
+  bool empty() const { return size == 0; }
+
+  void push(i64 key, int v) {
+    buckets[bucketOf(key)].emplace_back(key, v);
+    ++size;
+  }
+
+  std::pair<i64, int> pop() {
+    if (buckets[0].empty()) {
+      int i = 1;
+      while (buckets[i].empty()) {
+        ++i;
+      }
+      last = std::min_element(buckets[i].begin(), buckets[i].end())->first;
+      for (auto& entry : buckets[i]) {  // every entry moves to a lower bucket
+        buckets[bucketOf(entry.first)].push_back(entry);
+      }
+      buckets[i].clear();
+    }
+    auto top = buckets[0].back();
+    buckets[0].pop_back();
+    --size;
+    return top;
+  }
+
+ private:
+  std::vector<std::pair<i64, int>> buckets[65];
+  i64 last = 0;
+  int size = 0;
+
+  int bucketOf(i64 key) const {
+    return key == last ? 0 : 64 - __builtin_clzll(key ^ last);
+  }
+};
+
+};  // namespace mcmf
+
+// ShortestPath selects how each phase finds the layer graph:
+//   mcmf::SPFA        - Bellman-Ford on the raw costs every phase.
+//   mcmf::BinaryHeap  - Bellman-Ford once for potentials, then Dijkstra on
+//   mcmf::RadixHeap     Johnson reduced costs (cost + pot[u] - pot[v] >= 0).
+// The blocking-flow DFS is shared: it walks edges with zero reduced cost.
+//
+// After a solve, setCapacity()/setCost() edit single edges and the next
+// mcmf() re-optimises from the current flow instead of from zero: edits that
+// break optimality saturate the offending residual edge, and only the
+// resulting imbalances are routed along shortest paths before the usual
+// augmentation phases resume.
+template <typename ShortestPath = mcmf::SPFA>
 class MinCostMaxFlow {
  private:
+  static constexpr bool useSPFA = std::is_same_v<ShortestPath, mcmf::SPFA>;
+
+  using Heap = std::conditional_t<useSPFA, mcmf::BinaryHeap, ShortestPath>;
+
   int V;
   i64 totalCost;
+  bool frozen;
+  bool solved;
+  bool potValid;  // pot makes every residual reduced cost non-negative
+
+  // Builder. EL[i] and EL[i ^ 1] are an edge and its back edge.
   std::vector<std::tuple<int, i64, i64, i64>> EL;
   std::vector<std::vector<int>> AL;
+
+  // CSR form, filled by finalize(). The edges out of u are the slots
+  // [start[u], start[u + 1]), stored as parallel arrays so the hot loops
+  // stream through memory instead of chasing AL -> EL.
+  std::vector<int> start;
+  std::vector<int> to;
+  std::vector<i64> res;  // residual capacity
+  std::vector<i64> cost;
+  std::vector<int> rev;   // slot of the back edge
+  std::vector<int> slot;  // EL index -> CSR slot
+
   std::vector<i64> d;
+  std::vector<i64> pot;     // potentials, see potValid
+  std::vector<i64> excess;  // inflow - outflow left behind by edits
   std::vector<int> last;
   std::vector<int> vis;
+  std::vector<int> path;      // slots of the edges on the current s-u path
+  std::vector<int> prevEdge;  // shortest-path tree of route()
+  Heap heap;
 
   bool SPFA(int s, int t) {  // SPFA to find augmenting path in residual graph
     d.assign(V, INF);
@@ -26,11 +146,10 @@ class MinCostMaxFlow {
       int u = q.front();
       q.pop();
       vis[u] = 0;
-      for (auto& idx : AL[u]) {                // explore neighbors of u
-        auto& [v, cap, flow, cost] = EL[idx];  // stored in EL[idx]
-        if ((cap - flow > 0) &&
-            (d[v] > d[u] + cost)) {  // positive residual edge
-          d[v] = d[u] + cost;
+      for (int e = start[u]; e < start[u + 1]; ++e) {  // explore neighbors
+        int v = to[e];
+        if ((res[e] > 0) && (d[v] > d[u] + cost[e])) {  // positive residual
+          d[v] = d[u] + cost[e];
           if (!vis[v]) {
             q.push(v), vis[v] = 1;
           }
@@ -40,58 +159,372 @@ class MinCostMaxFlow {
     return d[t] != INF;  // has an augmenting path
   }
 
-  i64 DFS(int u, int t, i64 f = INF) {  // traverse from s->t
-    if ((u == t) || (f == 0)) {
-      return f;
-    }
-    vis[u] = 1;
-    for (int& i = last[u]; i < (int)AL[u].size(); ++i) {  // from last edge
-      auto& [v, cap, flow, cost] = EL[AL[u][i]];
-      if (!vis[v] && d[v] == d[u] + cost) {  // in current layer graph
-        if (i64 pushed = DFS(v, t, std::min(f, cap - flow))) {
-          totalCost += pushed * cost;
-          flow += pushed;
-          auto& [rv, rcap, rflow, rcost] = EL[AL[u][i] ^ 1];  // back edge
-          rflow -= pushed;
-          vis[u] = 0;
-          return pushed;
+  // Bellman-Ford from a virtual source joined to every vertex at cost 0, so
+  // every residual edge gets a non-negative reduced cost, reachable or not.
+  // Requires no negative cycles.
+  void initPotentials() {
+    pot.assign(V, 0);
+    std::queue<int> q;
+    for (int u = 0; u < V; ++u) {
+      q.push(u), vis[u] = 1;
+    }
+    while (!q.empty()) {
+      int u = q.front();
+      q.pop();
+      vis[u] = 0;
+      for (int e = start[u]; e < start[u + 1]; ++e) {
+        int v = to[e];
+        if ((res[e] > 0) && (pot[v] > pot[u] + cost[e])) {
+          pot[v] = pot[u] + cost[e];
+          if (!vis[v]) {
+            q.push(v), vis[v] = 1;
+          }
+        }
+      }
+    }
+  }
+
+  bool dijkstra(int s, int t) {  // shortest path over reduced costs
+    d.assign(V, INF);
+    d[s] = 0;
+    heap.clear();
+    heap.push(0, s);
+    while (!heap.empty()) {
+      auto [du, u] = heap.pop();
+      if (du != d[u]) {
+        continue;  // stale entry
+      }
+      if (u == t) {
+        break;  // everything still queued is at least d[t] away
+      }
+      for (int e = start[u]; e < start[u + 1]; ++e) {
+        int v = to[e];
+        i64 nd = du + cost[e] + pot[u] - pot[v];
+        if ((res[e] > 0) && (d[v] > nd)) {
+          d[v] = nd;
+          heap.push(nd, v);
+        }
+      }
+    }
+    if (d[t] == INF) {
+      return false;
+    }
+
+    // pot += min(d, d[t]) keeps every reduced cost non-negative, and makes
+    // the edges of every shortest s-t path exactly tight. Setting d = pot lets
+    // DFS test tightness with the same d[v] == d[u] + cost check as SPFA.
+    i64 dt = d[t];
+    for (int v = 0; v < V; ++v) {
+      pot[v] += std::min(d[v], dt);
+      d[v] = pot[v];
+    }
+    return true;
+  }
+
+  void ensurePotentials() {
+    if (!potValid) {
+      finalize();
+      initPotentials();
+      potValid = true;
+    }
+  }
+
+  // Saturate any residual direction of an edited edge whose reduced cost went
+  // negative, leaving the imbalance at its endpoints for repair().
+  void fixReducedCost(int e) {
+    for (int a : {e, rev[e]}) {
+      int u = to[rev[a]], v = to[a];
+      if (res[a] > 0 && cost[a] + pot[u] - pot[v] < 0) {
+        totalCost += res[a] * cost[a];
+        excess[u] -= res[a];
+        excess[v] += res[a];
+        res[rev[a]] += res[a];
+        res[a] = 0;
+      }
+    }
+  }
+
+  // Dijkstra from x over reduced costs to the nearest vertex that can absorb
+  // its imbalance: a deficit (excess) one when forward (backward), or s or t,
+  // whose flow value is free to change. Backward searches walk edges into u.
+  bool route(int x, int s, int t, bool forward) {
+    d.assign(V, INF);
+    d[x] = 0;
+    heap.clear();
+    heap.push(0, x);
+    int y = -1;
+    while (!heap.empty()) {
+      auto [du, u] = heap.pop();
+      if (du != d[u]) {
+        continue;  // stale entry
+      }
+      if (u == s || u == t || (forward ? excess[u] < 0 : excess[u] > 0)) {
+        y = u;
+        break;
+      }
+      for (int e = start[u]; e < start[u + 1]; ++e) {
+        int v = to[e];
+        int a = forward ? e : rev[e];  // the edge u->v, or v->u when backward
+        i64 nd = du + cost[a] + (forward ? pot[u] - pot[v] : pot[v] - pot[u]);
+        if ((res[a] > 0) && (d[v] > nd)) {
+          d[v] = nd;
+          prevEdge[v] = a;
+          heap.push(nd, v);
+        }
+      }
+    }
+    if (y == -1) {
+      return false;
+    }
+
+    i64 dy = d[y];
+    for (int v = 0; v < V; ++v) {  // same update as dijkstra(), mirrored
+      pot[v] += forward ? std::min(d[v], dy) : -std::min(d[v], dy);
+    }
+
+    i64 f = forward ? excess[x] : -excess[x];
+    if (y != s && y != t) {
+      f = std::min(f, forward ? -excess[y] : excess[y]);
+    }
+    auto next = [&](int v) {  // one step along the path, from y towards x
+      return forward ? to[rev[prevEdge[v]]] : to[prevEdge[v]];
+    };
+    for (int v = y; v != x; v = next(v)) {
+      f = std::min(f, res[prevEdge[v]]);
+    }
+    for (int v = y; v != x; v = next(v)) {
+      int a = prevEdge[v];
+      totalCost += f * cost[a];
+      res[a] -= f;
+      res[rev[a]] += f;
+    }
+    excess[x] += forward ? -f : f;
+    if (y != s && y != t) {
+      excess[y] += forward ? f : -f;
+    }
+    return true;
+  }
+
+  // Route the imbalances left by edits: every excess to a deficit (or back to
+  // s, or on to t), then every remaining deficit from s or t.
+  void repair(int s, int t) {
+    excess[s] = excess[t] = 0;  // s and t absorb any change in flow value
+    for (int x = 0; x < V; ++x) {
+      while (excess[x] > 0 && route(x, s, t, true)) {
+      }
+    }
+    for (int x = 0; x < V; ++x) {
+      while (excess[x] < 0 && route(x, s, t, false)) {
+      }
+    }
+  }
+
+  bool layerGraph(int s, int t) {
+    if constexpr (useSPFA) {
+      return SPFA(s, t);
+    } else {
+      return dijkstra(s, t);
+    }
+  }
+
+  // DFS from s->t with an explicit stack, so long layer graphs cannot
+  // overflow the call stack. vis[] marks the vertices on the current path.
+  // After each augmentation only the edges from the first saturated one
+  // onwards are popped, and the search resumes from its tail.
+  i64 blockingFlow(int s, int t) {
+    i64 total = 0;
+    path.clear();
+    int u = s;
+    vis[s] = 1;
+    while (true) {
+      if (u == t) {
+        i64 f = INF;
+        for (int e : path) {
+          f = std::min(f, res[e]);
+        }
+        int cut = -1;
+        for (int i = 0; i < static_cast<int>(path.size()); ++i) {
+          int e = path[i];
+          totalCost += f * cost[e];
+          res[e] -= f;
+          res[rev[e]] += f;  // back edge
+          if (cut == -1 && res[e] == 0) {
+            cut = i;
+          }
+        }
+        total += f;
+        for (int i = cut; i < static_cast<int>(path.size()); ++i) {
+          vis[to[path[i]]] = 0;
         }
+        u = to[rev[path[cut]]];  // tail of the first saturated edge
+        path.resize(cut);
+        continue;
       }
+
+      int& e = last[u];  // from last edge
+      while (e < start[u + 1] &&
+             (res[e] == 0 || vis[to[e]] || d[to[e]] != d[u] + cost[e])) {
+        ++e;  // not in current layer graph
+      }
+      if (e < start[u + 1]) {
+        path.push_back(e);
+        u = to[e];
+        vis[u] = 1;
+      } else if (u == s) {
+        vis[s] = 0;
+        return total;
+      } else {  // dead end, retreat and skip the edge that led here
+        vis[u] = 0;
+        u = to[rev[path.back()]];
+        path.pop_back();
+        ++last[u];
+      }
+    }
+  }
+
+  void thaw() {  // write the residuals back into EL's flows
+    for (int idx = 0; idx < static_cast<int>(EL.size()); ++idx) {
+      auto& [v, cap, flow, c] = EL[idx];
+      flow = cap - res[slot[idx]];
     }
-    vis[u] = 0;
-    return 0;
+    frozen = false;
   }
 
  public:
-  MinCostMaxFlow(int initialV) : V(initialV), totalCost(0) {
+  MinCostMaxFlow(int initialV)
+      : V(initialV),
+        totalCost(0),
+        frozen(false),
+        solved(false),
+        potValid(false) {
     EL.clear();
     AL.assign(V, std::vector<int>());
     vis.assign(V, 0);
+    excess.assign(V, 0);
+    prevEdge.assign(V, -1);
   }
 
   // if you are adding a bidirectional edge u<->v with weight w into your
   // flow graph, set directed = false (default value is directed = true)
-  void add_edge(int u, int v, i64 w, i64 c, bool directed = true) {
+  // Returns the id of the u->v edge, for setCapacity()/setCost()/getFlow().
+  int add_edge(int u, int v, i64 w, i64 c, bool directed = true) {
     if (u == v) {
-      return;  // safeguard: no self loop
+      return -1;  // safeguard: no self loop
+    }
+    if (solved) {
+      ensurePotentials();  // the new edge is checked against them below
+    }
+    if (frozen) {
+      thaw();  // keeps the flow found so far
     }
+    int id = EL.size();
     EL.emplace_back(v, w, 0, c);     // u->v, cap w, flow 0, cost c
     AL[u].push_back(EL.size() - 1);  // remember this index
     EL.emplace_back(u, 0, 0, -c);    // back edge
     AL[v].push_back(EL.size() - 1);  // remember this index
+    if (solved && c + pot[u] - pot[v] < 0) {  // would be a negative cycle
+      std::get<2>(EL[id]) = w;
+      std::get<2>(EL[id + 1]) = -w;
+      totalCost += w * c;
+      excess[u] -= w;
+      excess[v] += w;
+    }
     if (!directed) {
       add_edge(v, u, w, c);  // add again in reverse
     }
+    return id;
   }
 
-  std::pair<i64, i64> mcmf(int s, int t) {
-    i64 mf = 0;                    // mf stands for max_flow
-    while (SPFA(s, t)) {           // an O(V^2*E) algorithm
-      last.assign(V, 0);           // important speedup
-      while (i64 f = DFS(s, t)) {  // exhaust blocking flow
-        mf += f;
+  void setCapacity(int id, i64 w) {
+    if (solved) {
+      ensurePotentials();
+    }
+    finalize();
+    std::get<1>(EL[id]) = w;
+    int e = slot[id];
+    if (i64 over = res[rev[e]] - w; over > 0) {  // shed flow above w
+      totalCost -= over * cost[e];
+      excess[to[rev[e]]] += over;
+      excess[to[e]] -= over;
+      res[rev[e]] = w;
+    }
+    res[e] = w - res[rev[e]];
+    if (solved) {
+      fixReducedCost(e);
+    }
+  }
+
+  void setCost(int id, i64 c) {
+    if (solved) {
+      ensurePotentials();
+    }
+    finalize();
+    std::get<3>(EL[id]) = c;
+    std::get<3>(EL[id ^ 1]) = -c;
+    int e = slot[id];
+    totalCost += res[rev[e]] * (c - cost[e]);
+    cost[e] = c;
+    cost[rev[e]] = -c;
+    if (solved) {
+      fixReducedCost(e);
+    }
+  }
+
+  i64 getFlow(int id) const {
+    return frozen ? res[rev[slot[id]]] : std::get<2>(EL[id]);
+  }
+
+  // Freeze the builder into CSR form. mcmf() calls this itself; a later
+  // add_edge() thaws the graph again.
+  void finalize() {
+    if (frozen) {
+      return;
+    }
+    int m = static_cast<int>(EL.size());
+    start.assign(V + 1, 0);
+    for (int u = 0; u < V; ++u) {
+      start[u + 1] = start[u] + static_cast<int>(AL[u].size());
+    }
+    slot.resize(m);
+    for (int u = 0; u < V; ++u) {
+      int e = start[u];
+      for (int idx : AL[u]) {
+        slot[idx] = e++;
       }
     }
+    to.resize(m), res.resize(m), cost.resize(m), rev.resize(m);
+    for (int idx = 0; idx < m; ++idx) {
+      auto& [v, cap, flow, c] = EL[idx];
+      int e = slot[idx];
+      to[e] = v;
+      res[e] = cap - flow;
+      cost[e] = c;
+      rev[e] = slot[idx ^ 1];
+    }
+    frozen = true;
+  }
+
+  // Returns {max flow, min cost} of the current graph. Later calls continue
+  // from the flow already found, so only edits since then cost anything.
+  std::pair<i64, i64> mcmf(int s, int t) {
+    finalize();
+    if constexpr (!useSPFA) {
+      ensurePotentials();  // the only O(VE) pass in Dijkstra mode
+    }
+    if (solved) {
+      repair(s, t);
+    }
+    while (layerGraph(s, t)) {                      // an O(V^2*E) algorithm
+      last.assign(start.begin(), start.end() - 1);  // important speedup
+      blockingFlow(s, t);
+    }
+    solved = true;
+    potValid = !useSPFA;  // SPFA phases do not maintain pot
+
+    i64 mf = 0;  // mf stands for max_flow, the net outflow of s
+    for (int idx : AL[s]) {
+      mf += std::get<1>(EL[idx]) - res[slot[idx]];
+    }
     return {mf, totalCost};
   }
 };
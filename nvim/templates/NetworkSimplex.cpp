@@ -0,0 +1,241 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+using i64 = long long;
+
+const i64 INF = 1e18;  // INF = 1e18, not 2^63-1 to avoid overflow
+
+// Primal network simplex with block search pivoting. Same interface as
+// MinCostMaxFlow, and the running time does not grow with the flow value. A
+// pivot scans arcs in blocks of sqrt(E) until a block has a violator (all E
+// arcs when few are left), walks the cycle it closes and shifts the re-hung
+// subtree. There is no good bound on the number of pivots: on deep,
+// path-like graphs almost every pivot is degenerate and closes a cycle
+// through the whole path so far, which is quadratic.
+//
+// Max flow is folded into a min-cost circulation: an extra t->s arc with cost
+// -BIG (BIG > any simple path cost), so every extra unit of flow pays off
+// before any cost is considered. The spanning tree starts as a star of
+// artificial u->root arcs. Children are kept as linked lists, so a pivot
+// only touches the potentials and depths of the subtree it re-hangs.
+class NetworkSimplex {
+ private:
+  int V;
+  int root;
+
+  std::vector<int> from, to;
+  std::vector<i64> cap, cost, flow;
+  std::vector<char> inTree;
+
+  std::vector<int> parent;  // parent in the spanning tree, -1 for root
+  std::vector<int> pred;    // tree arc between u and parent[u]
+  std::vector<int> depth;
+  std::vector<int> child, next, prev;  // children as doubly linked lists
+  std::vector<i64> pi;                 // tree arcs have reduced cost 0
+  std::vector<int> stack;
+
+  i64 reducedCost(int e) const { return cost[e] + pi[from[e]] - pi[to[e]]; }
+
+  void unlink(int u) {
+    if (prev[u] != -1) {
+      next[prev[u]] = next[u];
+    } else {
+      child[parent[u]] = next[u];
+    }
+    if (next[u] != -1) {
+      prev[next[u]] = prev[u];
+    }
+  }
+
+  void link(int u, int p) {
+    parent[u] = p;
+    prev[u] = -1;
+    next[u] = child[p];
+    if (next[u] != -1) {
+      prev[next[u]] = u;
+    }
+    child[p] = u;
+  }
+
+  // How much arc e violates optimality; positive means it may enter.
+  i64 violation(int e) {
+    if (inTree[e] || cap[e] == 0) {
+      return 0;
+    }
+    if (flow[e] == 0) {
+      return -reducedCost(e);  // at lower bound, wants rc < 0
+    }
+    return flow[e] == cap[e] ? reducedCost(e) : 0;
+  }
+
+  // Scan arcs in blocks of B starting after the previous entering arc, and
+  // take the worst violator of the first block that has one.
+  int findEnteringArc(int& start, int B) {
+    int m = static_cast<int>(from.size()) - V;  // artificial arcs never enter
+    int best = -1, count = 0;
+    i64 worst = 0;
+    for (int k = 0; k < m; ++k) {
+      int e = (start + k) % m;
+      if (i64 x = violation(e); x > worst) {
+        worst = x;
+        best = e;
+      }
+      if (++count == B) {
+        if (best != -1) {
+          start = e + 1;
+          return best;
+        }
+        count = 0;
+      }
+    }
+    return best;
+  }
+
+  // Push around the cycle closed by arc `in`, then swap `in` for the leaving
+  // arc. The last blocking arc in cycle order (from the apex) leaves, which
+  // keeps the tree strongly feasible and rules out cycling.
+  void pivot(int in) {
+    bool forward = flow[in] == 0;
+    int first = forward ? from[in] : to[in];
+    int second = forward ? to[in] : from[in];
+
+    int a = first, b = second;  // climb to the apex of the cycle
+    while (a != b) {
+      if (depth[a] >= depth[b]) {
+        a = parent[a];
+      } else {
+        b = parent[b];
+      }
+    }
+    int join = a;
+
+    // first side is walked downwards (parent -> u), second side upwards.
+    i64 delta = cap[in];
+    int out = -1, side = 0;
+    for (int u = first; u != join; u = parent[u]) {
+      int e = pred[u];
+      i64 r = to[e] == u ? cap[e] - flow[e] : flow[e];
+      if (r < delta) {
+        delta = r, out = u, side = 1;
+      }
+    }
+    for (int u = second; u != join; u = parent[u]) {
+      int e = pred[u];
+      i64 r = from[e] == u ? cap[e] - flow[e] : flow[e];
+      if (r <= delta) {
+        delta = r, out = u, side = 2;
+      }
+    }
+
+    if (delta > 0) {
+      flow[in] += forward ? delta : -delta;
+      for (int u = first; u != join; u = parent[u]) {
+        flow[pred[u]] += to[pred[u]] == u ? delta : -delta;
+      }
+      for (int u = second; u != join; u = parent[u]) {
+        flow[pred[u]] += from[pred[u]] == u ? delta : -delta;
+      }
+    }
+    if (side == 0) {
+      return;  // `in` went from one bound to the other, tree is unchanged
+    }
+
+    // Re-hang the subtree below `out`: reverse the parent links from the
+    // endpoint of `in` inside that subtree up to `out`.
+    inTree[pred[out]] = 0;
+    inTree[in] = 1;
+    int top = side == 1 ? first : second;
+    i64 shift = from[in] == top ? -reducedCost(in) : reducedCost(in);
+    int u = top;
+    int p = side == 1 ? second : first;
+    int pe = in;
+    while (true) {
+      int nextU = parent[u], nextPe = pred[u];
+      unlink(u);
+      link(u, p);
+      pred[u] = pe;
+      if (u == out) {
+        break;
+      }
+      p = u, pe = nextPe, u = nextU;
+    }
+
+    // Only the re-hung subtree moves: its potentials by one constant that
+    // makes `in` tight, its depths from scratch.
+    stack.assign(1, top);
+    while (!stack.empty()) {
+      int v = stack.back();
+      stack.pop_back();
+      pi[v] += shift;
+      depth[v] = depth[parent[v]] + 1;
+      for (int c = child[v]; c != -1; c = next[c]) {
+        stack.push_back(c);
+      }
+    }
+  }
+
+ public:
+  NetworkSimplex(int initialV) : V(initialV), root(initialV) {}
+
+  // if you are adding a bidirectional edge u<->v with weight w into your
+  // flow graph, set directed = false (default value is directed = true)
+  void add_edge(int u, int v, i64 w, i64 c, bool directed = true) {
+    if (u == v) {
+      return;  // safeguard: no self loop
+    }
+    from.push_back(u), to.push_back(v);
+    cap.push_back(w), cost.push_back(c);
+    if (!directed) {
+      add_edge(v, u, w, c);  // add again in reverse
+    }
+  }
+
+  std::pair<i64, i64> mcmf(int s, int t) {
+    int m = static_cast<int>(from.size());
+    i64 big = 1, sourceCap = 0;
+    for (int e = 0; e < m; ++e) {
+      big += std::abs(cost[e]);
+      sourceCap += from[e] == s ? cap[e] : 0;
+    }
+    from.push_back(t), to.push_back(s);  // the t->s return arc, index m
+    cap.push_back(sourceCap), cost.push_back(-big);
+    for (int u = 0; u < V; ++u) {  // artificial arcs, u -> root
+      from.push_back(u), to.push_back(root);
+      cap.push_back(INF), cost.push_back(0);
+    }
+
+    int total = static_cast<int>(from.size());
+    flow.assign(total, 0);
+    inTree.assign(total, 0);
+    parent.assign(V + 1, -1);
+    pred.assign(V + 1, -1);
+    depth.assign(V + 1, 1);
+    child.assign(V + 1, -1);
+    next.assign(V + 1, -1);
+    prev.assign(V + 1, -1);
+    pi.assign(V + 1, 0);
+    depth[root] = 0;
+    for (int u = 0; u < V; ++u) {
+      link(u, root);
+      pred[u] = m + 1 + u;
+      inTree[m + 1 + u] = 1;
+    }
+
+    int B = std::max(10, static_cast<int>(std::sqrt(m + 1.0)));
+    int start = 0, in;
+    while ((in = findEnteringArc(start, B)) != -1) {
+      pivot(in);
+    }
+
+    i64 totalCost = 0;
+    for (int e = 0; e < m; ++e) {
+      totalCost += flow[e] * cost[e];
+    }
+    i64 mf = flow[m];
+    from.resize(m), to.resize(m), cap.resize(m), cost.resize(m);
+    return {mf, totalCost};
+  }
+};
@@ -0,0 +1,118 @@
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Persistent sum SegmentTree over positions [0, n). Every update copies the
+// root-to-leaf path into a new version and shares the rest. Nodes live in a
+// single arena and refer to their children by 32-bit index; node 0 is the
+// all-zero tree that every untouched child points at, and version 0 is empty.
+//
+// For "k-th smallest in a[l..r]": compress the values, let version i + 1 add
+// 1 at a[i] to version i, then kthElement(l, r + 1, k).
+template <typename T = long long>
+class PersistentSegmentTree {
+ public:
+  PersistentSegmentTree(int n, std::size_t reserve = 0) : n_(n) {
+    nodes_.reserve(reserve + 1);
+    reset();
+  }
+
+  // Adds diff at pos on top of version v. Returns the new version's id.
+  int update(int v, int pos, T diff) {
+    std::uint32_t cur = copy(roots_[v]);
+    roots_.push_back(cur);
+
+    int L = 0, R = n_ - 1;
+    nodes_[cur].sum += diff;
+    while (L < R) {
+      int mid = (L + R) / 2;
+      std::uint32_t next;
+      if (pos <= mid) {
+        next = copy(nodes_[cur].left);
+        nodes_[cur].left = next;
+        R = mid;
+      } else {
+        next = copy(nodes_[cur].right);
+        nodes_[cur].right = next;
+        L = mid + 1;
+      }
+      cur = next;
+      nodes_[cur].sum += diff;
+    }
+    marks_.push_back(nodes_.size());
+    return static_cast<int>(roots_.size()) - 1;
+  }
+
+  T query(int v, int l, int r) const {
+    return query(roots_[v], 0, n_ - 1, l, r);
+  }
+
+  // Smallest pos such that version hi minus version lo sums to at least k
+  // over [0, pos], or -1 if the whole difference is below k. The
+  // differences must be non-negative.
+  int kthElement(int lo, int hi, T k) const {
+    std::uint32_t a = roots_[lo], b = roots_[hi];
+    if (k <= 0 || nodes_[b].sum - nodes_[a].sum < k) {
+      return -1;
+    }
+    int L = 0, R = n_ - 1;
+    while (L < R) {
+      int mid = (L + R) / 2;
+      T left = nodes_[nodes_[b].left].sum - nodes_[nodes_[a].left].sum;
+      if (left >= k) {
+        a = nodes_[a].left, b = nodes_[b].left;
+        R = mid;
+      } else {
+        k -= left;
+        a = nodes_[a].right, b = nodes_[b].right;
+        L = mid + 1;
+      }
+    }
+    return L;
+  }
+
+  int versions() const { return static_cast<int>(roots_.size()); }
+
+  // Drops every version after v and frees their nodes in one go.
+  void rollback(int v) {
+    roots_.resize(v + 1);
+    marks_.resize(v + 1);
+    nodes_.resize(marks_.back());
+  }
+
+  // Back to the single empty version, keeping the arena's capacity for the
+  // next test case.
+  void reset() {
+    nodes_.assign(1, Node{});
+    roots_.assign(1, 0);
+    marks_.assign(1, 1);
+  }
+
+ private:
+  struct Node {
+    T sum = 0;
+    std::uint32_t left = 0, right = 0;
+  };
+
+  int n_;
+  std::vector<Node> nodes_;         // the arena, bump-allocated
+  std::vector<std::uint32_t> roots_;
+  std::vector<std::size_t> marks_;  // arena size right after each version
+
+  std::uint32_t copy(std::uint32_t idx) {
+    nodes_.push_back(nodes_[idx]);
+    return static_cast<std::uint32_t>(nodes_.size()) - 1;
+  }
+
+  T query(std::uint32_t idx, int L, int R, int l, int r) const {
+    if (idx == 0 || r < L || R < l) {
+      return 0;
+    }
+    if (l <= L && R <= r) {
+      return nodes_[idx].sum;
+    }
+    int mid = (L + R) / 2;
+    return query(nodes_[idx].left, L, mid, l, r) +
+           query(nodes_[idx].right, mid + 1, R, l, r);
+  }
+};
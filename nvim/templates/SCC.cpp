@@ -1,38 +1,245 @@
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdlib>
-#include <stack>
+#include <thread>
+#include <utility>
 #include <vector>
 
+// Tarjan's SCC, iterative, on a CSR copy of the graph, so neither long paths
+// nor 10^7 edges are a problem. Component ids come out in reverse
+// topological order: an edge between components goes from a higher id to a
+// lower one.
 class SCC {
  public:
-  SCC(int vertices) : computed(false), V(vertices), numSCCs(0), time(0) {
-    adj.resize(V);
+  SCC(int vertices) : computed(false), V(vertices), time(0), numSCCs(0) {
     componentOf.assign(V, -1);
   }
 
-  void addEdge(int v, int w) { adj[v].push_back(w); }
+  void addEdge(int v, int w) {
+    edges.emplace_back(v, w);
+    computed = false;
+  }
 
   void tarjanSCC() {
     if (computed) {
       return;  // avoid recomputing
     }
 
+    freeze();
     time = 0;
     numSCCs = 0;
     componentOf.assign(V, -1);
 
     std::vector<int> discovery(V, -1);
     std::vector<int> lowest(V, -1);
-    std::stack<int> st;
+    std::vector<int> next(start.begin(), start.end() - 1);  // next edge slot
+    std::vector<int> st;    // Tarjan's stack of open vertices
+    std::vector<int> path;  // the DFS call stack
 
     // Process all vertices
     for (int i = 0; i < V; i++) {
-      if (discovery[i] == -1) {
-        tarjanSCC(i, discovery, lowest, st);
+      if (discovery[i] != -1) {
+        continue;
+      }
+      discovery[i] = lowest[i] = ++time;
+      st.push_back(i);
+      path.push_back(i);
+
+      while (!path.empty()) {
+        int u = path.back();
+        if (next[u] < start[u + 1]) {
+          int v = to[next[u]++];
+          // Only consider vertices not yet assigned to a component
+          if (discovery[v] == -1) {
+            discovery[v] = lowest[v] = ++time;
+            st.push_back(v);
+            path.push_back(v);
+          } else if (componentOf[v] == -1) {
+            // Back edge to a vertex in current SCC
+            lowest[u] = std::min(lowest[u], discovery[v]);
+          }
+          continue;
+        }
+
+        path.pop_back();
+        if (!path.empty()) {
+          lowest[path.back()] = std::min(lowest[path.back()], lowest[u]);
+        }
+
+        // If u is root of an SCC
+        if (lowest[u] == discovery[u]) {
+          int v;
+          do {
+            v = st.back();
+            st.pop_back();
+            componentOf[v] = numSCCs;
+          } while (v != u);
+
+          numSCCs++;
+        }
+      }
+    }
+
+    groupMembers();
+    computed = true;
+  }
+
+  // Same partition as tarjanSCC(), also numbered in reverse topological
+  // order, but computed on `threads` threads:
+  //   1. trim: peel off vertices with no in- or no out-edges left, each a
+  //      component of its own, level by level as in Kahn's algorithm;
+  //   2. forward-backward: the vertices that a high-degree pivot both
+  //      reaches and is reached from, by two parallel BFS. Usually this is
+  //      the giant component;
+  //   3. colouring: push the largest vertex id forward to a fixpoint. A
+  //      vertex that keeps its own id is a root, and its component is what
+  //      reaches it backwards within its colour. Repeat on what is left.
+  // The final renumbering is a sequential O(V + E) pass.
+  void parallelSCC(int threads = 0) {
+    if (computed) {
+      return;
+    }
+    if (threads <= 0) {
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    freeze();
+    freezeReverse();
+    componentOf.assign(V, -1);
+    std::atomic<int> nextId = 0;  // ids are renumbered at the end
+    std::vector<std::vector<int>> buffers(threads);
+
+    // 1. Trim. in/out count the edges from/to vertices still present.
+    std::vector<int> in(V), out(V);
+    parallelFor(threads, V, [&](int lo, int hi, int) {
+      for (int v = lo; v < hi; v++) {
+        for (int e = start[v]; e < start[v + 1]; e++) {
+          out[v] += to[e] != v;
+        }
+        for (int e = rstart[v]; e < rstart[v + 1]; e++) {
+          in[v] += rto[e] != v;
+        }
+      }
+    });
+    std::vector<int> frontier = gather(threads, buffers, V, [&](int v) {
+      return in[v] == 0 || out[v] == 0;
+    });
+    while (!frontier.empty()) {
+      parallelFor(threads, frontier.size(), [&](int lo, int hi, int t) {
+        for (int i = lo; i < hi; i++) {
+          int v = frontier[i], expected = -1;  // may be queued twice
+          if (!std::atomic_ref(componentOf[v])
+                   .compare_exchange_strong(expected, nextId++)) {
+            continue;
+          }
+          for (int e = start[v]; e < start[v + 1]; e++) {
+            if (to[e] != v && std::atomic_ref(in[to[e]]).fetch_sub(1) == 1) {
+              buffers[t].push_back(to[e]);
+            }
+          }
+          for (int e = rstart[v]; e < rstart[v + 1]; e++) {
+            if (rto[e] != v && std::atomic_ref(out[rto[e]]).fetch_sub(1) == 1) {
+              buffers[t].push_back(rto[e]);
+            }
+          }
+        }
+      });
+      frontier = concat(buffers);
+    }
+
+    // 2. Forward-backward from the pivot maximising in * out degree.
+    std::vector<std::pair<long long, int>> best(threads, {-1, -1});
+    parallelFor(threads, V, [&](int lo, int hi, int t) {
+      for (int v = lo; v < hi; v++) {
+        long long score = static_cast<long long>(start[v + 1] - start[v]) *
+                          (rstart[v + 1] - rstart[v]);
+        if (componentOf[v] == -1 && score > best[t].first) {
+          best[t] = {score, v};
+        }
+      }
+    });
+    int pivot = std::max_element(best.begin(), best.end())->second;
+    if (pivot != -1) {
+      std::vector<int> fw = reach(threads, buffers, pivot, start, to);
+      std::vector<int> bw = reach(threads, buffers, pivot, rstart, rto);
+      int id = nextId++;
+      parallelFor(threads, V, [&](int lo, int hi, int) {
+        for (int v = lo; v < hi; v++) {
+          if (componentOf[v] == -1 && fw[v] && bw[v]) {
+            componentOf[v] = id;
+          }
+        }
+      });
+    }
+
+    // 3. Colouring.
+    std::vector<int> color(V), queued(V, 0);
+    while (true) {
+      std::vector<int> active = gather(threads, buffers, V, [&](int v) {
+        return componentOf[v] == -1;
+      });
+      if (active.empty()) {
+        break;
+      }
+      for (int v : active) {
+        color[v] = v;
       }
+
+      while (!active.empty()) {
+        parallelFor(threads, active.size(), [&](int lo, int hi, int t) {
+          for (int i = lo; i < hi; i++) {
+            int u = active[i];
+            // seq_cst, so the colour is read only after the flag is clear: a
+            // raise that still saw the flag set must show up in c.
+            std::atomic_ref(queued[u]).exchange(0, std::memory_order_seq_cst);
+            int c = std::atomic_ref(color[u]).load(std::memory_order_seq_cst);
+            for (int e = start[u]; e < start[u + 1]; e++) {
+              int w = to[e];
+              if (componentOf[w] != -1) {
+                continue;
+              }
+              std::atomic_ref cw(color[w]);
+              int cur = cw.load(std::memory_order_relaxed);
+              while (cur < c && !cw.compare_exchange_weak(cur, c)) {
+              }
+              int expected = 0;
+              if (cur < c &&
+                  std::atomic_ref(queued[w]).compare_exchange_strong(expected,
+                                                                     1)) {
+                buffers[t].push_back(w);
+              }
+            }
+          }
+        });
+        active = concat(buffers);
+      }
+
+      std::vector<int> roots = gather(threads, buffers, V, [&](int v) {
+        return componentOf[v] == -1 && color[v] == v;
+      });
+      parallelFor(threads, roots.size(), [&](int lo, int hi, int) {
+        std::vector<int> stack;
+        for (int i = lo; i < hi; i++) {  // colours are disjoint, no races
+          int r = roots[i], id = nextId++;
+          componentOf[r] = id;
+          stack.push_back(r);
+          while (!stack.empty()) {
+            int u = stack.back();
+            stack.pop_back();
+            for (int e = rstart[u]; e < rstart[u + 1]; e++) {
+              int w = rto[e];
+              if (color[w] == r && componentOf[w] == -1) {
+                componentOf[w] = id;
+                stack.push_back(w);
+              }
+            }
+          }
+        }
+      });
     }
 
+    renumber(nextId);
     computed = true;
   }
 
@@ -50,19 +257,54 @@ class SCC {
     return componentOf;
   }
 
-  // Get all vertices in a specific component
+  // Get all vertices in a specific component, in increasing order
   std::vector<int> getComponent(int compId) {
     if (!computed) {
       tarjanSCC();
     }
 
-    std::vector<int> result;
+    return std::vector<int>(members.begin() + memberStart[compId],
+                            members.begin() + memberStart[compId + 1]);
+  }
+
+  // The DAG of components. Its nodes are numbered in topological order, so
+  // every edge goes from a lower node to a higher one.
+  struct Condensation {
+    std::vector<int> nodeOf;  // vertex -> node
+    std::vector<int> weight;  // number of vertices in each node
+    std::vector<int> start;   // CSR: node u's edges go to
+    std::vector<int> to;      // to[start[u]..start[u + 1]), no duplicates
+  };
+
+  Condensation condensation() {
+    if (!computed) {
+      tarjanSCC();
+    }
+
+    Condensation dag;
+    dag.nodeOf.resize(V);
     for (int i = 0; i < V; i++) {
-      if (componentOf[i] == compId) {
-        result.push_back(i);
+      dag.nodeOf[i] = numSCCs - 1 - componentOf[i];
+    }
+    dag.weight.resize(numSCCs);
+    dag.start.assign(numSCCs + 1, 0);
+    std::vector<int> seen(numSCCs, -1);  // last node that linked to it
+    for (int node = 0; node < numSCCs; node++) {
+      int c = numSCCs - 1 - node;
+      dag.weight[node] = memberStart[c + 1] - memberStart[c];
+      for (int k = memberStart[c]; k < memberStart[c + 1]; k++) {
+        int u = members[k];
+        for (int e = start[u]; e < start[u + 1]; e++) {
+          int target = dag.nodeOf[to[e]];
+          if (target != node && seen[target] != node) {
+            seen[target] = node;
+            dag.to.push_back(target);
+          }
+        }
       }
+      dag.start[node + 1] = static_cast<int>(dag.to.size());
     }
-    return result;
+    return dag;
   }
 
   // Get all SCCs as lists of vertices
@@ -72,8 +314,8 @@ class SCC {
     }
 
     std::vector<std::vector<int>> result(numSCCs);
-    for (int i = 0; i < V; i++) {
-      result[componentOf[i]].push_back(i);
+    for (int c = 0; c < numSCCs; c++) {
+      result[c] = getComponent(c);
     }
     return result;
   }
@@ -84,44 +326,252 @@ class SCC {
   int time;  // For Tarjan's algorithm
   int numSCCs;
 
-  std::vector<std::vector<int>> adj;  // Adjacency list
-  std::vector<int> componentOf;       // Maps each vertex to its component ID
-
-  int tarjanSCC(int u,
-                std::vector<int>& discovery,
-                std::vector<int>& lowest,
-                std::stack<int>& st) {
-    discovery[u] = lowest[u] = ++time;
-    st.push(u);
-
-    for (int v : adj[u]) {
-      // Only consider vertices not yet assigned to a component
-      if (componentOf[v] == -1) {
-        // If not discovered, recursively visit
-        if (discovery[v] == -1) {
-          tarjanSCC(v, discovery, lowest, st);
-          lowest[u] = std::min(lowest[u], lowest[v]);
+  std::vector<std::pair<int, int>> edges;  // Builder edge list
+
+  // CSR form, filled by freeze(): the edges out of u go to
+  // to[start[u]..start[u + 1]).
+  std::vector<int> start;
+  std::vector<int> to;
+
+  std::vector<int> componentOf;  // Maps each vertex to its component ID
+  std::vector<int> memberStart;  // Component c is members[memberStart[c]..)
+  std::vector<int> members;
+
+  // Reverse CSR for parallelSCC(): the edges into u come from
+  // rto[rstart[u]..rstart[u + 1]).
+  std::vector<int> rstart;
+  std::vector<int> rto;
+
+  static constexpr int GRAIN = 1 << 12;  // least work worth its own thread
+
+  // work(lo, hi, t) on slices of [0, total), inline if total is small.
+  template <typename Work>
+  static void parallelFor(int threads, std::size_t total, Work work) {
+    long long k = std::min<long long>(threads, total / GRAIN + 1);
+    if (k == 1) {
+      work(0, static_cast<int>(total), 0);
+      return;
+    }
+    std::vector<std::thread> pool;
+    for (long long t = 0; t < k; t++) {
+      pool.emplace_back(work, total * t / k, total * (t + 1) / k, t);
+    }
+    for (auto& thread : pool) {
+      thread.join();
+    }
+  }
+
+  static std::vector<int> concat(std::vector<std::vector<int>>& buffers) {
+    std::vector<int> all;
+    for (auto& buffer : buffers) {
+      all.insert(all.end(), buffer.begin(), buffer.end());
+      buffer.clear();
+    }
+    return all;
+  }
+
+  // The vertices satisfying pred, in increasing order.
+  template <typename Pred>
+  static std::vector<int> gather(int threads,
+                                 std::vector<std::vector<int>>& buffers,
+                                 int n,
+                                 Pred pred) {
+    parallelFor(threads, n, [&](int lo, int hi, int t) {
+      for (int v = lo; v < hi; v++) {
+        if (pred(v)) {
+          buffers[t].push_back(v);
         }
-        // Back edge to a vertex in current SCC
-        else {
-          lowest[u] = std::min(lowest[u], discovery[v]);
+      }
+    });
+    return concat(buffers);
+  }
+
+  // Level-synchronous parallel BFS from src over the vertices without a
+  // component yet. Returns 1 for every vertex reached.
+  std::vector<int> reach(int threads,
+                         std::vector<std::vector<int>>& buffers,
+                         int src,
+                         const std::vector<int>& first,
+                         const std::vector<int>& adj) {
+    std::vector<int> seen(V, 0);
+    seen[src] = 1;
+    std::vector<int> frontier = {src};
+    while (!frontier.empty()) {
+      parallelFor(threads, frontier.size(), [&](int lo, int hi, int t) {
+        for (int i = lo; i < hi; i++) {
+          int u = frontier[i];
+          for (int e = first[u]; e < first[u + 1]; e++) {
+            int w = adj[e], expected = 0;
+            if (componentOf[w] == -1 &&
+                std::atomic_ref(seen[w]).compare_exchange_strong(expected, 1)) {
+              buffers[t].push_back(w);
+            }
+          }
         }
+      });
+      frontier = concat(buffers);
+    }
+    return seen;
+  }
+
+  // Compact ids [0, ids) to [0, numSCCs) in reverse topological order, by
+  // Kahn's algorithm on the condensation from its sinks.
+  void renumber(int ids) {
+    std::vector<int> dense(ids, -1);
+    numSCCs = 0;
+    for (int i = 0; i < V; i++) {
+      int& d = dense[componentOf[i]];
+      if (d == -1) {
+        d = numSCCs++;
       }
+      componentOf[i] = d;
     }
+    groupMembers();
 
-    // If u is root of an SCC
-    if (lowest[u] == discovery[u]) {
-      // Process all vertices in the current SCC
-      int v;
-      do {
-        v = st.top();
-        st.pop();
-        componentOf[v] = numSCCs;
-      } while (v != u);
+    std::vector<int> outdeg(numSCCs, 0), order;
+    for (int u = 0; u < V; u++) {
+      for (int e = start[u]; e < start[u + 1]; e++) {
+        outdeg[componentOf[u]] += componentOf[u] != componentOf[to[e]];
+      }
+    }
+    for (int c = 0; c < numSCCs; c++) {
+      if (outdeg[c] == 0) {
+        order.push_back(c);
+      }
+    }
+    std::vector<int> newId(numSCCs);
+    for (int k = 0; k < static_cast<int>(order.size()); k++) {
+      int c = order[k];
+      newId[c] = k;
+      for (int m = memberStart[c]; m < memberStart[c + 1]; m++) {
+        int u = members[m];
+        for (int e = rstart[u]; e < rstart[u + 1]; e++) {
+          int d = componentOf[rto[e]];
+          if (d != c && --outdeg[d] == 0) {
+            order.push_back(d);
+          }
+        }
+      }
+    }
+    for (int i = 0; i < V; i++) {
+      componentOf[i] = newId[componentOf[i]];
+    }
+    groupMembers();
+  }
 
-      numSCCs++;
+  // Group the vertices by component, for getComponent().
+  void groupMembers() {
+    memberStart.assign(numSCCs + 1, 0);
+    for (int i = 0; i < V; i++) {
+      memberStart[componentOf[i] + 1]++;
     }
+    for (int c = 0; c < numSCCs; c++) {
+      memberStart[c + 1] += memberStart[c];
+    }
+    members.resize(V);
+    std::vector<int> fill(memberStart.begin(), memberStart.end() - 1);
+    for (int i = 0; i < V; i++) {
+      members[fill[componentOf[i]]++] = i;
+    }
+  }
 
-    return lowest[u];
+  void freezeReverse() {
+    rstart.assign(V + 1, 0);
+    for (auto [v, w] : edges) {
+      rstart[w + 1]++;
+    }
+    for (int u = 0; u < V; u++) {
+      rstart[u + 1] += rstart[u];
+    }
+    rto.resize(edges.size());
+    std::vector<int> fill(rstart.begin(), rstart.end() - 1);
+    for (auto [v, w] : edges) {
+      rto[fill[w]++] = v;
+    }
   }
+
+  void freeze() {
+    start.assign(V + 1, 0);
+    for (auto [v, w] : edges) {
+      start[v + 1]++;
+    }
+    for (int u = 0; u < V; u++) {
+      start[u + 1] += start[u];
+    }
+    to.resize(edges.size());
+    std::vector<int> fill(start.begin(), start.end() - 1);
+    for (auto [v, w] : edges) {
+      to[fill[v]++] = w;
+    }
+  }
+};
+
+// 2-SAT on top of SCC. Variable x has the literals x (vertex 2x) and not x
+// (vertex 2x + 1); a clause (a or b) adds the implications not a -> b and
+// not b -> a. Literals are passed as (variable, negated).
+class TwoSat {
+ public:
+  TwoSat(int n) : n(n) {}
+
+  // A fresh variable, e.g. for auxiliary encodings.
+  int addVariable() { return n++; }
+
+  // (a xor negA) or (b xor negB)
+  void addClause(int a, bool negA, int b, bool negB) {
+    implications.emplace_back(literal(a, !negA), literal(b, negB));
+    implications.emplace_back(literal(b, !negB), literal(a, negA));
+  }
+
+  // (a xor negA) implies (b xor negB)
+  void implies(int a, bool negA, int b, bool negB) {
+    addClause(a, !negA, b, negB);
+  }
+
+  void setValue(int a, bool value) { addClause(a, !value, a, !value); }
+
+  // At most one of the literals holds, with O(k) clauses: the prefix
+  // variable p_i means "one of the first i + 1 literals holds".
+  void atMostOne(const std::vector<std::pair<int, bool>>& literals) {
+    int k = static_cast<int>(literals.size());
+    if (k <= 1) {
+      return;
+    }
+    int prev = -1;
+    for (int i = 0; i < k; i++) {
+      auto [x, neg] = literals[i];
+      int p = addVariable();
+      implies(x, neg, p, false);
+      if (prev != -1) {
+        implies(prev, false, p, false);
+        implies(prev, false, x, !neg);
+      }
+      prev = p;
+    }
+  }
+
+  // A satisfying assignment of every variable, auxiliary ones included, or
+  // an empty vector if there is none.
+  std::vector<bool> solve() {
+    SCC scc(2 * n);
+    for (auto [u, v] : implications) {
+      scc.addEdge(u, v);
+    }
+    const std::vector<int>& comp = scc.getComponentMap();
+
+    std::vector<bool> value(n);
+    for (int x = 0; x < n; x++) {
+      if (comp[2 * x] == comp[2 * x + 1]) {
+        return {};
+      }
+      // Ids are reverse topological: take the literal that comes later.
+      value[x] = comp[2 * x] < comp[2 * x + 1];
+    }
+    return value;
+  }
+
+ private:
+  int n;
+  std::vector<std::pair<int, int>> implications;
+
+  static int literal(int x, bool neg) { return 2 * x + neg; }
 };
@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <climits>
+#include <vector>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace stree {
+
+constexpr int B = 16;  // keys per node: 64 bytes, one cache line
+
+struct alignas(64) Node {
+  int key[B];
+};
+
+// Number of keys in the node below x.
+inline int countLess(const Node& node, int x) {
+#ifdef __AVX2__
+  __m256i v = _mm256_set1_epi32(x);
+  auto keys = reinterpret_cast<const __m256i*>(node.key);
+  __m256i lo = _mm256_cmpgt_epi32(v, _mm256_load_si256(keys));
+  __m256i hi = _mm256_cmpgt_epi32(v, _mm256_load_si256(keys + 1));
+  unsigned mask = _mm256_movemask_ps(_mm256_castsi256_ps(lo)) |
+                  _mm256_movemask_ps(_mm256_castsi256_ps(hi)) << 8;
+  return __builtin_popcount(mask);
+#else
+  int c = 0;  // fixed trip count, so it still vectorises
+  for (int j = 0; j < B; ++j) {
+    c += node.key[j] < x;
+  }
+  return c;
+#endif
+}
+
+// Min of node.key[from..to], INT_MAX if empty.
+inline int rangeMin(const Node& node, int from, int to) {
+#ifdef __AVX2__
+  __m256i idxLo = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  __m256i idxHi = _mm256_setr_epi32(8, 9, 10, 11, 12, 13, 14, 15);
+  __m256i below = _mm256_set1_epi32(from - 1);
+  __m256i above = _mm256_set1_epi32(to + 1);
+  __m256i inLo = _mm256_and_si256(_mm256_cmpgt_epi32(idxLo, below),
+                                  _mm256_cmpgt_epi32(above, idxLo));
+  __m256i inHi = _mm256_and_si256(_mm256_cmpgt_epi32(idxHi, below),
+                                  _mm256_cmpgt_epi32(above, idxHi));
+  __m256i inf = _mm256_set1_epi32(INT_MAX);
+  auto keys = reinterpret_cast<const __m256i*>(node.key);
+  __m256i m = _mm256_min_epi32(
+      _mm256_blendv_epi8(inf, _mm256_load_si256(keys), inLo),
+      _mm256_blendv_epi8(inf, _mm256_load_si256(keys + 1), inHi));
+  m = _mm256_min_epi32(m, _mm256_permute2x128_si256(m, m, 1));
+  m = _mm256_min_epi32(m, _mm256_shuffle_epi32(m, 0b01001110));
+  m = _mm256_min_epi32(m, _mm256_shuffle_epi32(m, 0b10110001));
+  return _mm256_cvtsi256_si32(m);
+#else
+  int m = INT_MAX;
+  for (int j = 0; j < B; ++j) {
+    m = std::min(m, from <= j && j <= to ? node.key[j] : INT_MAX);
+  }
+  return m;
+#endif
+}
+
+};  // namespace stree
+
+// Static search tree over a sorted array (S+ tree): B keys per node and
+// B + 1 implicit children, so a search touches one cache line per level and
+// compares the whole line at once. The leaves are the sorted keys themselves,
+// and an internal key is the smallest key of the subtree to its right.
+// Keys must be below INT_MAX, which pads the nodes.
+class STree {
+ public:
+  STree(std::vector<int> keys) : n_(keys.size()) {
+    std::sort(keys.begin(), keys.end());
+    int nodes = std::max(1, (n_ + stree::B - 1) / stree::B);
+    layers_.emplace_back(nodes);
+    for (int i = 0; i < nodes * stree::B; ++i) {
+      leaf(i) = i < n_ ? keys[i] : INT_MAX;
+    }
+
+    for (int h = 1; nodes > 1; ++h) {
+      nodes = (nodes + stree::B) / (stree::B + 1);
+      layers_.emplace_back(nodes);
+      for (int k = 0; k < nodes; ++k) {
+        for (int j = 0; j < stree::B; ++j) {
+          long long first = k * (stree::B + 1LL) + j + 1;  // leftmost leaf
+          for (int l = 1; l < h && first * stree::B < n_; ++l) {
+            first *= stree::B + 1;
+          }
+          layers_[h][k].key[j] =
+              first * stree::B < n_ ? leaf(first * stree::B) : INT_MAX;
+        }
+      }
+    }
+  }
+
+  // Number of keys below x.
+  int rank(int x) const {
+    int k = 0;
+    for (int h = static_cast<int>(layers_.size()) - 1; h > 0; --h) {
+      k = k * (stree::B + 1) + stree::countLess(layers_[h][k], x);
+    }
+    return std::min(n_, k * stree::B + stree::countLess(layers_[0][k], x));
+  }
+
+  // Smallest key >= x, or INT_MAX if there is none.
+  int lower_bound(int x) const {
+    int i = rank(x);
+    return i < n_ ? leaf(i) : INT_MAX;
+  }
+
+ private:
+  int n_;
+  std::vector<std::vector<stree::Node>> layers_;  // layers_[0] are the leaves
+
+  int& leaf(int i) { return layers_[0][i / stree::B].key[i % stree::B]; }
+
+  int leaf(int i) const { return layers_[0][i / stree::B].key[i % stree::B]; }
+};
+
+// B-ary range-min tree: level h + 1 holds the min of each node of level h,
+// up to a single root node. A query reads two nodes per level and takes a
+// masked min across each; an update recomputes the one node per level above
+// the changed element.
+class SMinTree {
+ public:
+  SMinTree(const std::vector<int>& data) : n_(data.size()) {
+    int len = n_;
+    do {
+      int nodes = std::max(1, (len + stree::B - 1) / stree::B);
+      levels_.emplace_back(nodes);
+      for (auto& node : levels_.back()) {
+        std::fill(node.key, node.key + stree::B, INT_MAX);
+      }
+      len = nodes;
+    } while (len > 1);
+
+    for (int i = 0; i < n_; ++i) {
+      at(0, i) = data[i];
+    }
+    for (int h = 1; h < static_cast<int>(levels_.size()); ++h) {
+      for (int i = 0; i < static_cast<int>(levels_[h - 1].size()); ++i) {
+        at(h, i) = stree::rangeMin(levels_[h - 1][i], 0, stree::B - 1);
+      }
+    }
+  }
+
+  int query(int l, int r) const {
+    int result = INT_MAX;
+    for (int h = 0; l <= r; ++h) {
+      const auto& level = levels_[h];
+      int nl = l / stree::B, nr = r / stree::B;
+      int jl = l % stree::B, jr = r % stree::B;
+      if (nl == nr) {
+        return std::min(result, stree::rangeMin(level[nl], jl, jr));
+      }
+      result = std::min(result, stree::rangeMin(level[nl], jl, stree::B - 1));
+      result = std::min(result, stree::rangeMin(level[nr], 0, jr));
+      l = nl + 1, r = nr - 1;  // whole nodes in between, one level up
+    }
+    return result;
+  }
+
+  void update(int pos, int val) {
+    at(0, pos) = val;
+    for (int h = 1; h < static_cast<int>(levels_.size()); ++h) {
+      pos /= stree::B;
+      at(h, pos) = stree::rangeMin(levels_[h - 1][pos], 0, stree::B - 1);
+    }
+  }
+
+ private:
+  int n_;
+  std::vector<std::vector<stree::Node>> levels_;
+
+  int& at(int h, int i) { return levels_[h][i / stree::B].key[i % stree::B]; }
+};
@@ -1,5 +1,7 @@
 #include <algorithm>
+#include <bit>
 #include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 #include <limits>
 #include <type_traits>
@@ -43,6 +45,141 @@ struct Max {
   }
 };
 
+// x combined with itself len times, by doubling unless op has a shortcut.
+template <typename T, typename BinaryOp>
+T repeat(const BinaryOp& op, T x, long long len) {
+  if constexpr (std::is_same_v<BinaryOp, Sum>) {
+    return x * static_cast<T>(len);
+  } else if constexpr (std::is_same_v<BinaryOp, Min> ||
+                       std::is_same_v<BinaryOp, Max>) {
+    return x;
+  } else {
+    T result = op.template identity<T>();
+    for (; len > 0; len >>= 1, x = op(x, x)) {
+      if (len & 1) {
+        result = op(result, x);
+      }
+    }
+    return result;
+  }
+}
+
+// Lazy actions for SegmentTree. An action is a family of maps F<T> on node
+// values, given by
+//   - identity<T>(), the map that changes nothing,
+//   - compose(f, g), the map "g, then f",
+//   - apply(op, x, f, len), f applied to a segment of len elements whose
+//     combined value under the monoid op is x.
+
+// An optional value without std::optional: a plain struct with a tag, so
+// the lazy array stays one contiguous block.
+template <typename T>
+struct Tagged {
+  T value{};
+  bool set = false;
+
+  Tagged() = default;
+  Tagged(const T& value) : value(value), set(true) {}
+};
+
+// Range assignment. Works with any monoid.
+struct Assign {
+  template <typename T>
+  using F = Tagged<T>;
+
+  template <typename T>
+  F<T> identity() const noexcept {
+    return {};
+  }
+
+  template <typename T>
+  F<T> compose(const F<T>& f, const F<T>& g) const noexcept {
+    return f.set ? f : g;
+  }
+
+  template <typename T, typename BinaryOp>
+  T apply(const BinaryOp& op, const T& x, const F<T>& f, long long len) const {
+    return f.set ? repeat(op, f.value, len) : x;
+  }
+};
+
+// Range add, for Sum, Min and Max.
+struct Add {
+  template <typename T>
+  using F = T;
+
+  template <typename T>
+  F<T> identity() const noexcept {
+    return 0;
+  }
+
+  template <typename T>
+  F<T> compose(const F<T>& f, const F<T>& g) const noexcept {
+    return f + g;
+  }
+
+  template <typename T, typename BinaryOp>
+  T apply(const BinaryOp&, const T& x, const F<T>& f, long long len) const {
+    static_assert(std::is_same_v<BinaryOp, Sum> ||
+                      std::is_same_v<BinaryOp, Min> ||
+                      std::is_same_v<BinaryOp, Max>,
+                  "Add requires Sum, Min or Max");
+    if constexpr (std::is_same_v<BinaryOp, Sum>) {
+      return x + f * static_cast<T>(len);
+    } else {
+      return x + f;
+    }
+  }
+};
+
+template <typename T>
+struct Linear {
+  T mul = 1;
+  T add = 0;
+};
+
+// Range affine map x -> mul * x + add, for Sum, and for Min and Max as long
+// as mul >= 0.
+struct Affine {
+  template <typename T>
+  using F = Linear<T>;
+
+  template <typename T>
+  F<T> identity() const noexcept {
+    return {};
+  }
+
+  template <typename T>
+  F<T> compose(const F<T>& f, const F<T>& g) const noexcept {
+    return {f.mul * g.mul, f.mul * g.add + f.add};
+  }
+
+  template <typename T, typename BinaryOp>
+  T apply(const BinaryOp&, const T& x, const F<T>& f, long long len) const {
+    static_assert(std::is_same_v<BinaryOp, Sum> ||
+                      std::is_same_v<BinaryOp, Min> ||
+                      std::is_same_v<BinaryOp, Max>,
+                  "Affine requires Sum, Min or Max");
+    if constexpr (std::is_same_v<BinaryOp, Sum>) {
+      return f.mul * x + f.add * static_cast<T>(len);
+    } else {
+      return f.mul * x + f.add;
+    }
+  }
+};
+
+// What a lazy tree starts its positions at. Assign overwrites values, so the
+// identity is fine; Add and Affine compute from them, and on the identity of
+// Min or Max (a limit of T) that overflows, so those start at T{} instead.
+template <typename T, typename BinaryOp, typename Action>
+T initialValue() {
+  if constexpr (std::is_same_v<Action, Assign>) {
+    return BinaryOp().template identity<T>();
+  } else {
+    return T{};
+  }
+}
+
 };  // namespace segtree
 
 // Eager SegmentTree.
@@ -58,7 +195,7 @@ class ESegmentTree {
 
   T query(int l, int r) const { return query(1, 0, n_ - 1, l, r); }
 
-  void update(int pos, int val) { update(1, 0, n_ - 1, pos, val); }
+  void update(int pos, T val) { update(1, 0, n_ - 1, pos, val); }
 
   T kthElement(T k) const { return kthElement(1, 0, n_ - 1, k); }
 
@@ -137,15 +274,133 @@ class ESegmentTree {
   }
 };
 
+// Iterative SegmentTree over 2 * bit_ceil(n) nodes, leaf i at st_[size_ + i]
+// and padding leaves at identity. No recursion anywhere: query and update
+// walk the leaf-to-root paths, and the binary searches climb, then descend.
 template <typename T = long long, typename BinaryOp = segtree::Sum>
+class ISegmentTree {
+ public:
+  ISegmentTree(int sz)
+      : n_(sz),
+        size_(std::bit_ceil(static_cast<unsigned>(std::max(sz, 1)))),
+        op_(),
+        st_(2 * size_, op_.template identity<T>()) {}
+
+  ISegmentTree(const std::vector<T>& data) : ISegmentTree(data.size()) {
+    std::copy(data.begin(), data.end(), st_.begin() + size_);
+    for (int i = size_ - 1; i > 0; --i) {
+      st_[i] = op_(st_[left(i)], st_[right(i)]);
+    }
+  }
+
+  T get(int pos) const { return st_[size_ + pos]; }
+
+  T query(int l, int r) const {
+    T sumL = op_.template identity<T>(), sumR = op_.template identity<T>();
+    for (l += size_, r += size_ + 1; l < r; l >>= 1, r >>= 1) {
+      if (l & 1) {
+        sumL = op_(sumL, st_[l++]);
+      }
+      if (r & 1) {
+        sumR = op_(st_[--r], sumR);
+      }
+    }
+    return op_(sumL, sumR);
+  }
+
+  void update(int pos, T val) {
+    pos += size_;
+    st_[pos] = val;
+    while (pos >>= 1) {
+      st_[pos] = op_(st_[left(pos)], st_[right(pos)]);
+    }
+  }
+
+  // Largest r in [l - 1, n - 1] with pred(query(l, r)), for a pred that holds
+  // on the identity and stays false once false as r grows. With Sum and
+  // pred = (sum < k), max_right(0, pred) + 1 is the kth element.
+  template <typename Pred>
+  int max_right(int l, Pred pred) const {
+    if (l == n_) {
+      return n_ - 1;
+    }
+    l += size_;
+    T sum = op_.template identity<T>();
+    do {
+      while (!(l & 1)) {
+        l >>= 1;
+      }
+      if (!pred(op_(sum, st_[l]))) {
+        while (l < size_) {
+          l = left(l);
+          if (pred(op_(sum, st_[l]))) {
+            sum = op_(sum, st_[l++]);
+          }
+        }
+        return l - size_ - 1;
+      }
+      sum = op_(sum, st_[l++]);
+    } while ((l & -l) != l);
+    return n_ - 1;
+  }
+
+  // Smallest l in [0, r + 1] with pred(query(l, r)), the mirror image.
+  template <typename Pred>
+  int min_left(int r, Pred pred) const {
+    if (r == -1) {
+      return 0;
+    }
+    r += size_ + 1;
+    T sum = op_.template identity<T>();
+    do {
+      --r;
+      while (r > 1 && (r & 1)) {
+        r >>= 1;
+      }
+      if (!pred(op_(st_[r], sum))) {
+        while (r < size_) {
+          r = right(r);
+          if (pred(op_(st_[r], sum))) {
+            sum = op_(st_[r--], sum);
+          }
+        }
+        return r + 1 - size_;
+      }
+      sum = op_(st_[r], sum);
+    } while ((r & -r) != r);
+    return 0;
+  }
+
+ private:
+  const int n_;
+  const int size_;
+  const BinaryOp op_{};
+
+  std::vector<T> st_;
+
+  static constexpr int left(int x) { return x << 1; }
+
+  static constexpr int right(int x) { return (x << 1) + 1; }
+};
+
+// Lazy SegmentTree, parameterised by a monoid (BinaryOp: operator() and
+// identity<T>()) and an Action on it (see segtree::Assign). update(l, r, f)
+// applies f to every element of [l, r]; for Assign, f converts from T.
+// Positions start at segtree::initialValue: the identity for Assign, T{}
+// otherwise.
+template <typename T = long long,
+          typename BinaryOp = segtree::Sum,
+          typename Action = segtree::Assign>
 class SegmentTree {
  public:
+  using F = typename Action::template F<T>;
+
   SegmentTree(int sz)
       : n_(sz),
         op_(),
-        st_(4 * n_, op_.template identity<T>()),
-        lazy_(4 * n_, 0),
-        hasUpdates_(4 * n_, false) {}
+        act_(),
+        st_(4 * n_, segtree::initialValue<T, BinaryOp, Action>()),
+        lazy_(4 * n_, act_.template identity<T>()) {}
 
   SegmentTree(const std::vector<T>& data) : SegmentTree(data.size()) {
     build(data, 1, 0, n_ - 1);
@@ -153,7 +408,7 @@ class SegmentTree {
 
   T query(int l, int r) { return query(1, 0, n_ - 1, l, r); }
 
-  void update(int l, int r, T val) { update(1, 0, n_ - 1, l, r, val); }
+  void update(int l, int r, const F& f) { update(1, 0, n_ - 1, l, r, f); }
 
   // find the k-th smallest element in the range [l, r]
   T kthElement(int k) { return kthElement(1, 0, n_ - 1, k); }
@@ -163,11 +418,11 @@ class SegmentTree {
 
   BinaryOp op_{};
 
-  std::vector<T> st_;
+  Action act_{};
 
-  std::vector<T> lazy_;
+  std::vector<T> st_;
 
-  std::vector<bool> hasUpdates_;
+  std::vector<F> lazy_;  // pending for the children; st_ is already updated
 
   static int left(int i) { return i << 1; }
   static int right(int i) { return (i << 1) + 1; }
@@ -185,72 +440,59 @@ class SegmentTree {
     }
   }
 
-  void propagate(int idx, int l, int r) {
-    if (!hasUpdates_[idx]) {
-      return;
-    }
-    hasUpdates_[idx] = false;
-
-    if constexpr (std::is_same_v<BinaryOp, segtree::Sum>) {
-      // for sum, there is a need to multiply by the size of the segment.
-      st_[idx] = (lazy_[idx] * (r - l + 1));
-    } else if constexpr (std::is_same_v<BinaryOp, segtree::Min> ||
-                         std::is_same_v<BinaryOp, segtree::Max>) {
-      // for min/max, the value is simply propagated, reflecting a replace.
-      st_[idx] = lazy_[idx];
-    }
-
-    // non-leaf, propagate downwards.
+  void apply(int idx, int l, int r, const F& f) {
+    st_[idx] = act_.apply(op_, st_[idx], f, r - l + 1);
     if (l != r) {
-      lazy_[left(idx)] = lazy_[idx];
-      lazy_[right(idx)] = lazy_[idx];
+      lazy_[idx] = act_.compose(f, lazy_[idx]);
+    }
+  }
 
-      hasUpdates_[left(idx)] = true;
-      hasUpdates_[right(idx)] = true;
+  void propagate(int idx, int l, int r) {
+    if (l == r) {
+      return;
     }
-    lazy_[idx] = 0;  // reset. Not necessary.
-  };
+    int mid = (l + r) / 2;
+    apply(left(idx), l, mid, lazy_[idx]);
+    apply(right(idx), mid + 1, r, lazy_[idx]);
+    lazy_[idx] = act_.template identity<T>();
+  }
 
   T query(int idx, int tL, int tR, int l, int r) {
     if (l > r) {
       return op_.template identity<T>();
     }
 
-    propagate(idx, tL, tR);
-
     if (l <= tL && r >= tR) {
       return st_[idx];
     }
 
+    propagate(idx, tL, tR);
+
     int mid = (tL + tR) / 2;
     return op_(query(left(idx), tL, mid, l, std::min(r, mid)),
                query(right(idx), mid + 1, tR, std::max(l, mid + 1), r));
   }
 
-  void update(int idx, int tL, int tR, int l, int r, T val) {
-    propagate(idx, tL, tR);
-
+  void update(int idx, int tL, int tR, int l, int r, const F& f) {
     if (l > tR || r < tL) {
       return;
     }
 
     if (l <= tL && r >= tR) {
-      lazy_[idx] = val;
-      hasUpdates_[idx] = true;
-      propagate(idx, tL, tR);
+      apply(idx, tL, tR, f);
       return;
     }
 
+    propagate(idx, tL, tR);
+
     int mid = (tL + tR) / 2;
-    update(left(idx), tL, mid, l, r, val);
-    update(right(idx), mid + 1, tR, l, r, val);
+    update(left(idx), tL, mid, l, r, f);
+    update(right(idx), mid + 1, tR, l, r, f);
 
     st_[idx] = op_(st_[left(idx)], st_[right(idx)]);
   }
 
   T kthElement(int idx, int tL, int tR, int k) {
-    propagate(idx, tL, tR);
-
     if constexpr (std::is_same_v<BinaryOp, segtree::Sum>) {
       if (k > st_[idx]) {
         return -1;
@@ -260,6 +502,8 @@ class SegmentTree {
         return tL;
       }
 
+      propagate(idx, tL, tR);
+
       int mid = (tL + tR) / 2;
       if (st_[left(idx)] >= k) {
         return kthElement(left(idx), tL, mid, k);
@@ -273,3 +517,324 @@ class SegmentTree {
     }
   }
 };
+
+// Dynamic SegmentTree over the positions [lo, hi], with hi - lo up to about
+// 2^62 and no compression. Same policies as SegmentTree. A node's children
+// are created only when an update has to split it, from a pool indexed by
+// uint32_t, so memory grows with the updated paths; queries allocate
+// nothing. Every position starts at init, by default as in SegmentTree.
+template <typename T = long long,
+          typename BinaryOp = segtree::Sum,
+          typename Action = segtree::Assign>
+class DSegmentTree {
+ public:
+  using F = typename Action::template F<T>;
+
+  DSegmentTree(long long lo,
+               long long hi,
+               T init = segtree::initialValue<T, BinaryOp, Action>())
+      : lo_(lo), hi_(hi), init_(init) {
+    newNode(hi - lo + 1);  // the root, node 0
+  }
+
+  T query(long long l, long long r) const { return query(0, lo_, hi_, l, r); }
+
+  void update(long long l, long long r, const F& f) {
+    update(0, lo_, hi_, l, r, f);
+  }
+
+  // Number of nodes allocated so far.
+  std::size_t size() const { return nodes_.size(); }
+
+ private:
+  struct Node {
+    T val;
+    F lazy;
+    std::uint32_t left = 0, right = 0;  // 0: not created, the root is no child
+  };
+
+  long long lo_, hi_;
+  T init_;
+  BinaryOp op_{};
+  Action act_{};
+
+  std::vector<Node> nodes_;
+
+  std::uint32_t newNode(long long len) {
+    nodes_.push_back({segtree::repeat(op_, init_, len),
+                      act_.template identity<T>()});
+    return static_cast<std::uint32_t>(nodes_.size()) - 1;
+  }
+
+  void apply(std::uint32_t idx, long long l, long long r, const F& f) {
+    nodes_[idx].val = act_.apply(op_, nodes_[idx].val, f, r - l + 1);
+    if (l != r) {
+      nodes_[idx].lazy = act_.compose(f, nodes_[idx].lazy);
+    }
+  }
+
+  void propagate(std::uint32_t idx, long long l, long long r) {
+    long long mid = l + (r - l) / 2;
+    if (nodes_[idx].left == 0) {
+      std::uint32_t left = newNode(mid - l + 1);
+      std::uint32_t right = newNode(r - mid);
+      nodes_[idx].left = left;
+      nodes_[idx].right = right;
+    }
+    F f = nodes_[idx].lazy;
+    apply(nodes_[idx].left, l, mid, f);
+    apply(nodes_[idx].right, mid + 1, r, f);
+    nodes_[idx].lazy = act_.template identity<T>();
+  }
+
+  T query(std::uint32_t idx, long long tL, long long tR, long long l,
+          long long r) const {
+    l = std::max(l, tL), r = std::min(r, tR);
+    if (l > r) {
+      return op_.template identity<T>();
+    }
+
+    const Node& node = nodes_[idx];
+    if (l == tL && r == tR) {
+      return node.val;
+    }
+    if (node.left == 0) {  // never split: every position holds one value
+      T x = act_.apply(op_, init_, node.lazy, 1);
+      return segtree::repeat(op_, x, r - l + 1);
+    }
+
+    // Instead of pushing node.lazy down, apply it to the answer: an action
+    // maps any segment's value, not just a whole node's.
+    long long mid = tL + (tR - tL) / 2;
+    T sum = op_(query(node.left, tL, mid, l, r),
+                query(node.right, mid + 1, tR, l, r));
+    return act_.apply(op_, sum, node.lazy, r - l + 1);
+  }
+
+  void update(std::uint32_t idx, long long tL, long long tR, long long l,
+              long long r, const F& f) {
+    if (l > tR || r < tL) {
+      return;
+    }
+
+    if (l <= tL && r >= tR) {
+      apply(idx, tL, tR, f);
+      return;
+    }
+
+    propagate(idx, tL, tR);
+
+    long long mid = tL + (tR - tL) / 2;
+    update(nodes_[idx].left, tL, mid, l, r, f);
+    update(nodes_[idx].right, mid + 1, tR, l, r, f);
+
+    nodes_[idx].val =
+        op_(nodes_[nodes_[idx].left].val, nodes_[nodes_[idx].right].val);
+  }
+};
+
+// Segment tree beats (Ji): range chmin, chmax and add, with sum, min and max
+// queries via query<segtree::Sum>(l, r) and so on. Each node keeps its two
+// largest and two smallest distinct values and how often the extremes occur,
+// so a chmin that only lowers the maximum is applied without recursing.
+// Amortised O(log^2 n) per operation.
+template <typename T = long long>
+class SegmentTreeBeats {
+ public:
+  SegmentTreeBeats(int sz) : SegmentTreeBeats(std::vector<T>(sz, 0)) {}
+
+  SegmentTreeBeats(const std::vector<T>& data) : n_(data.size()), st_(4 * n_) {
+    build(data, 1, 0, n_ - 1);
+  }
+
+  void chmin(int l, int r, T x) { chmin(1, 0, n_ - 1, l, r, x); }
+
+  void chmax(int l, int r, T x) { chmax(1, 0, n_ - 1, l, r, x); }
+
+  void add(int l, int r, T x) { add(1, 0, n_ - 1, l, r, x); }
+
+  template <typename BinaryOp = segtree::Sum>
+  T query(int l, int r) {
+    return query<BinaryOp>(1, 0, n_ - 1, l, r);
+  }
+
+ private:
+  static constexpr T LOW = std::numeric_limits<T>::lowest();
+  static constexpr T HIGH = std::numeric_limits<T>::max();
+
+  struct Node {
+    T sum = 0;
+    T max1 = LOW, max2 = LOW;  // largest and second largest distinct value
+    T min1 = HIGH, min2 = HIGH;
+    int maxc = 0, minc = 0;    // occurrences of max1 and min1
+    T lazy = 0;                // pending add for the children
+  };
+
+  const int n_;
+
+  std::vector<Node> st_;
+
+  static int left(int i) { return i << 1; }
+  static int right(int i) { return (i << 1) + 1; }
+
+  void pull(int idx) {
+    Node& node = st_[idx];
+    const Node& a = st_[left(idx)];
+    const Node& b = st_[right(idx)];
+    node.sum = a.sum + b.sum;
+
+    if (a.max1 == b.max1) {
+      node.max1 = a.max1, node.maxc = a.maxc + b.maxc;
+      node.max2 = std::max(a.max2, b.max2);
+    } else {
+      const Node& hi = a.max1 > b.max1 ? a : b;
+      const Node& lo = a.max1 > b.max1 ? b : a;
+      node.max1 = hi.max1, node.maxc = hi.maxc;
+      node.max2 = std::max(hi.max2, lo.max1);
+    }
+
+    if (a.min1 == b.min1) {
+      node.min1 = a.min1, node.minc = a.minc + b.minc;
+      node.min2 = std::min(a.min2, b.min2);
+    } else {
+      const Node& lo = a.min1 < b.min1 ? a : b;
+      const Node& hi = a.min1 < b.min1 ? b : a;
+      node.min1 = lo.min1, node.minc = lo.minc;
+      node.min2 = std::min(lo.min2, hi.min1);
+    }
+  }
+
+  void build(const std::vector<T>& data, int idx, int l, int r) {
+    if (l == r) {
+      st_[idx].sum = st_[idx].max1 = st_[idx].min1 = data[l];
+      st_[idx].maxc = st_[idx].minc = 1;
+      return;
+    }
+    int mid = (l + r) / 2;
+    build(data, left(idx), l, mid);
+    build(data, right(idx), mid + 1, r);
+    pull(idx);
+  }
+
+  // Lower the maximum to x, for max2 < x < max1.
+  void applyChmin(int idx, T x) {
+    Node& node = st_[idx];
+    node.sum -= (node.max1 - x) * node.maxc;
+    if (node.min1 == node.max1) {
+      node.min1 = x;
+    } else if (node.min2 == node.max1) {
+      node.min2 = x;
+    }
+    node.max1 = x;
+  }
+
+  // Raise the minimum to x, for min1 < x < min2.
+  void applyChmax(int idx, T x) {
+    Node& node = st_[idx];
+    node.sum += (x - node.min1) * node.minc;
+    if (node.max1 == node.min1) {
+      node.max1 = x;
+    } else if (node.max2 == node.min1) {
+      node.max2 = x;
+    }
+    node.min1 = x;
+  }
+
+  void applyAdd(int idx, int len, T x) {
+    Node& node = st_[idx];
+    node.sum += x * len;
+    node.max1 += x, node.min1 += x;
+    if (node.max2 != LOW) {
+      node.max2 += x;
+    }
+    if (node.min2 != HIGH) {
+      node.min2 += x;
+    }
+    node.lazy += x;
+  }
+
+  void propagate(int idx, int l, int r) {
+    int mid = (l + r) / 2;
+    if (st_[idx].lazy != 0) {
+      applyAdd(left(idx), mid - l + 1, st_[idx].lazy);
+      applyAdd(right(idx), r - mid, st_[idx].lazy);
+      st_[idx].lazy = 0;
+    }
+    for (int child : {left(idx), right(idx)}) {
+      if (st_[child].max1 > st_[idx].max1) {
+        applyChmin(child, st_[idx].max1);
+      }
+      if (st_[child].min1 < st_[idx].min1) {
+        applyChmax(child, st_[idx].min1);
+      }
+    }
+  }
+
+  void chmin(int idx, int tL, int tR, int l, int r, T x) {
+    if (l > tR || r < tL || st_[idx].max1 <= x) {
+      return;
+    }
+    if (l <= tL && r >= tR && st_[idx].max2 < x) {
+      applyChmin(idx, x);
+      return;
+    }
+    propagate(idx, tL, tR);
+    int mid = (tL + tR) / 2;
+    chmin(left(idx), tL, mid, l, r, x);
+    chmin(right(idx), mid + 1, tR, l, r, x);
+    pull(idx);
+  }
+
+  void chmax(int idx, int tL, int tR, int l, int r, T x) {
+    if (l > tR || r < tL || st_[idx].min1 >= x) {
+      return;
+    }
+    if (l <= tL && r >= tR && st_[idx].min2 > x) {
+      applyChmax(idx, x);
+      return;
+    }
+    propagate(idx, tL, tR);
+    int mid = (tL + tR) / 2;
+    chmax(left(idx), tL, mid, l, r, x);
+    chmax(right(idx), mid + 1, tR, l, r, x);
+    pull(idx);
+  }
+
+  void add(int idx, int tL, int tR, int l, int r, T x) {
+    if (l > tR || r < tL) {
+      return;
+    }
+    if (l <= tL && r >= tR) {
+      applyAdd(idx, tR - tL + 1, x);
+      return;
+    }
+    propagate(idx, tL, tR);
+    int mid = (tL + tR) / 2;
+    add(left(idx), tL, mid, l, r, x);
+    add(right(idx), mid + 1, tR, l, r, x);
+    pull(idx);
+  }
+
+  template <typename BinaryOp>
+  T query(int idx, int tL, int tR, int l, int r) {
+    BinaryOp op;
+    if (l > tR || r < tL) {
+      return op.template identity<T>();
+    }
+    if (l <= tL && r >= tR) {
+      if constexpr (std::is_same_v<BinaryOp, segtree::Sum>) {
+        return st_[idx].sum;
+      } else if constexpr (std::is_same_v<BinaryOp, segtree::Min>) {
+        return st_[idx].min1;
+      } else {
+        static_assert(std::is_same_v<BinaryOp, segtree::Max>,
+                      "SegmentTreeBeats answers Sum, Min and Max");
+        return st_[idx].max1;
+      }
+    }
+    propagate(idx, tL, tR);
+    int mid = (tL + tR) / 2;
+    return op(query<BinaryOp>(left(idx), tL, mid, l, r),
+              query<BinaryOp>(right(idx), mid + 1, tR, l, r));
+  }
+};
@@ -1,4 +1,11 @@
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <numeric>
+#include <thread>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -10,11 +17,11 @@ class UnionFind {
   }
 
   int find(int x) noexcept {
-    if (parent_[x] != x) {
-      parent_[x] = find(parent_[x]);
+    while (parent_[x] != x) {
+      x = parent_[x] = parent_[parent_[x]];  // path halving
     }
 
-    return parent_[x];
+    return x;
   }
 
   bool connected(int x, int y) noexcept { return find(x) == find(y); }
@@ -53,63 +60,470 @@ class UnionFind {
   std::vector<int> size_;
 };
 
+// UnionFind in a single int array: data_[x] is x's parent, or minus the size
+// of its set if x is a root. Union by size, iterative path halving.
+class CompactUnionFind {
+ public:
+  CompactUnionFind(int n = 0) : components_(n), data_(n, -1) {}
+
+  // Adds a singleton set and returns its element.
+  int add() {
+    ++components_;
+    data_.push_back(-1);
+    return static_cast<int>(data_.size()) - 1;
+  }
+
+  int find(int x) noexcept {
+    while (data_[x] >= 0) {
+      if (data_[data_[x]] >= 0) {
+        data_[x] = data_[data_[x]];
+      }
+      x = data_[x];
+    }
+    return x;
+  }
+
+  bool connected(int x, int y) noexcept { return find(x) == find(y); }
+
+  void unite(int x, int y) noexcept {
+    int rootX = find(x);
+    int rootY = find(y);
+
+    if (rootX == rootY) {
+      return;
+    }
+
+    --components_;
+    if (data_[rootX] > data_[rootY]) {  // rootX has the smaller set
+      std::swap(rootX, rootY);
+    }
+    data_[rootX] += data_[rootY];
+    data_[rootY] = rootX;
+  }
+
+  int components() const noexcept { return components_; }
+
+  int size(int x) noexcept { return -data_[find(x)]; }
+
+ private:
+  int components_;
+
+  std::vector<int> data_;
+};
+
+// UnionFind that can undo unions: union by size without path compression,
+// so find is O(log n) and every unite changes two entries, which are saved.
+class RollbackUnionFind {
+ public:
+  RollbackUnionFind(int n) : components_(n), data_(n, -1) {}
+
+  int find(int x) const noexcept {
+    while (data_[x] >= 0) {
+      x = data_[x];
+    }
+    return x;
+  }
+
+  bool connected(int x, int y) const noexcept { return find(x) == find(y); }
+
+  void unite(int x, int y) {
+    int rootX = find(x);
+    int rootY = find(y);
+
+    if (rootX == rootY) {
+      return;
+    }
+
+    if (data_[rootX] > data_[rootY]) {
+      std::swap(rootX, rootY);
+    }
+    history_.emplace_back(rootY, data_[rootY]);
+    data_[rootX] += data_[rootY];
+    data_[rootY] = rootX;
+    --components_;
+  }
+
+  int components() const noexcept { return components_; }
+
+  int size(int x) const noexcept { return -data_[find(x)]; }
+
+  int snapshot() const noexcept { return static_cast<int>(history_.size()); }
+
+  // Undo every unite since snapshot() returned `to`.
+  void rollback(int to) {
+    while (static_cast<int>(history_.size()) > to) {
+      auto [child, size] = history_.back();
+      history_.pop_back();
+      data_[data_[child]] -= size;
+      data_[child] = size;
+      ++components_;
+    }
+  }
+
+ private:
+  int components_;
+
+  std::vector<int> data_;  // parent, or minus the size at a root
+  std::vector<std::pair<int, int>> history_;  // (old root, its old data_)
+};
+
+// Offline dynamic connectivity. Record edge insertions, deletions and
+// connectivity queries in time order, then solve() answers all queries in
+// O((m log q) log n). Each edge is alive over an interval of queries; the
+// interval goes onto O(log q) nodes of a segment tree over the queries, and
+// a DFS of that tree unites a node's edges on the way down and rolls them
+// back on the way up.
+class OfflineDynamicConnectivity {
+ public:
+  OfflineDynamicConnectivity(int n) : n_(n) {}
+
+  void addEdge(int u, int v) { open_[key(u, v)].push_back(queries_.size()); }
+
+  // Removes one copy of an edge that is currently present.
+  void removeEdge(int u, int v) {
+    auto& starts = open_[key(u, v)];
+    edges_.push_back({std::min(u, v), std::max(u, v), starts.back(),
+                      static_cast<int>(queries_.size())});
+    starts.pop_back();
+  }
+
+  // Is u connected to v at this point? The answer comes from solve().
+  void query(int u, int v) { queries_.emplace_back(u, v); }
+
+  // answers[i] for the i-th query() call.
+  std::vector<bool> solve() {
+    int q = static_cast<int>(queries_.size());
+    for (auto& [k, starts] : open_) {
+      for (int start : starts) {
+        edges_.push_back({static_cast<int>(k >> 32),
+                          static_cast<int>(k & 0xffffffff), start, q});
+      }
+    }
+    open_.clear();
+
+    size_ = std::bit_ceil(static_cast<unsigned>(std::max(q, 1)));
+    tree_.assign(2 * size_, {});
+    for (auto& [u, v, from, to] : edges_) {  // alive for queries [from, to)
+      for (int l = from + size_, r = to + size_; l < r; l >>= 1, r >>= 1) {
+        if (l & 1) {
+          tree_[l++].emplace_back(u, v);
+        }
+        if (r & 1) {
+          tree_[--r].emplace_back(u, v);
+        }
+      }
+    }
+
+    RollbackUnionFind uf(n_);
+    std::vector<bool> answers(q);
+    dfs(1, uf, answers);
+    return answers;
+  }
+
+ private:
+  struct Edge {
+    int u, v;
+    int from, to;
+  };
+
+  int n_;
+  int size_;
+  std::unordered_map<long long, std::vector<int>> open_;  // edge -> starts
+  std::vector<Edge> edges_;
+  std::vector<std::pair<int, int>> queries_;
+  std::vector<std::vector<std::pair<int, int>>> tree_;
+
+  static long long key(int u, int v) {
+    return static_cast<long long>(std::min(u, v)) << 32 | std::max(u, v);
+  }
+
+  void dfs(int idx, RollbackUnionFind& uf, std::vector<bool>& answers) {
+    int snap = uf.snapshot();
+    for (auto [u, v] : tree_[idx]) {
+      uf.unite(u, v);
+    }
+    if (idx >= size_) {
+      int i = idx - size_;
+      if (i < static_cast<int>(queries_.size())) {
+        answers[i] = uf.connected(queries_[i].first, queries_[i].second);
+      }
+    } else {
+      dfs(idx << 1, uf, answers);
+      dfs((idx << 1) + 1, uf, answers);
+    }
+    uf.rollback(snap);
+  }
+};
+
+// Lock-free UnionFind for many threads at once (Anderson-Woll style). A
+// root is linked under the other root only if it has the smaller index, by
+// CAS on its parent, so parents always have larger indices and no cycle can
+// form; a failed CAS means the root changed, so the union retries. find()
+// does path splitting with CAS, which never breaks that order either. Only
+// the parent words themselves are shared, so relaxed atomics suffice.
+class ConcurrentUnionFind {
+ public:
+  ConcurrentUnionFind(int n) : parent_(n) {
+    for (int i = 0; i < n; ++i) {
+      parent_[i].store(i, std::memory_order_relaxed);
+    }
+  }
+
+  int find(int x) noexcept {
+    while (true) {
+      int p = parent_[x].load(std::memory_order_relaxed);
+      if (p == x) {
+        return x;
+      }
+      int gp = parent_[p].load(std::memory_order_relaxed);
+      if (p != gp) {  // point x at its grandparent, fine if someone beat us
+        parent_[x].compare_exchange_weak(p, gp, std::memory_order_relaxed);
+      }
+      x = p;
+    }
+  }
+
+  bool connected(int x, int y) noexcept {
+    while (true) {
+      x = find(x), y = find(y);
+      if (x == y) {
+        return true;
+      }
+      if (parent_[x].load(std::memory_order_relaxed) == x) {
+        return false;  // x was still a root after y was found
+      }
+    }
+  }
+
+  // True if this call merged two sets.
+  bool unite(int x, int y) noexcept {
+    while (true) {
+      x = find(x), y = find(y);
+      if (x == y) {
+        return false;
+      }
+      if (x > y) {
+        std::swap(x, y);
+      }
+      int expected = x;
+      if (parent_[x].compare_exchange_strong(expected, y,
+                                             std::memory_order_relaxed)) {
+        return true;
+      }
+    }
+  }
+
+ private:
+  std::vector<std::atomic<int>> parent_;
+};
+
+// Component label of each vertex (the largest vertex in its component),
+// uniting the edges on `threads` threads, each taking a contiguous slice.
+inline std::vector<int> connectedComponents(
+    int n, const std::vector<std::pair<int, int>>& edges, int threads = 0) {
+  if (threads <= 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  ConcurrentUnionFind uf(n);
+  std::vector<int> label(n);
+  auto inParallel = [threads](std::size_t total, auto work) {
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t) {
+      std::size_t from = total * t / threads, to = total * (t + 1) / threads;
+      pool.emplace_back([=] { work(from, to); });
+    }
+    for (auto& thread : pool) {
+      thread.join();
+    }
+  };
+
+  inParallel(edges.size(), [&](std::size_t from, std::size_t to) {
+    for (std::size_t e = from; e < to; ++e) {
+      uf.unite(edges[e].first, edges[e].second);
+    }
+  });
+  inParallel(n, [&](std::size_t from, std::size_t to) {
+    for (std::size_t v = from; v < to; ++v) {
+      label[v] = uf.find(v);
+    }
+  });
+  return label;
+}
+
+// UnionFind over arbitrary hashable keys. Each new key is interned into the
+// next dense id through one open-addressing table (linear probing, load
+// factor <= 1/2), and the sets live in a CompactUnionFind over the ids.
 template <typename T, typename Hash = std::hash<T>>
 class DSU {
  private:
   using ConstRefT = const T&;
 
  public:
-  DSU() : components_(0) {}
+  DSU() : table_(16, -1) {}
 
-  T find(ConstRefT x) noexcept {
-    if (parent_.find(x) == parent_.end()) {
-      parent_.emplace(x, x);
-      rank_.emplace(x, 0);
-      size_.emplace(x, 1);
-      ++components_;
+  T find(ConstRefT x) noexcept { return keys_[uf_.find(id(x))]; }
+
+  bool connected(ConstRefT x, ConstRefT y) noexcept {
+    return uf_.find(id(x)) == uf_.find(id(y));
+  }
+
+  void unite(ConstRefT x, ConstRefT y) noexcept { uf_.unite(id(x), id(y)); }
 
-      return x;
+  int components() const noexcept { return uf_.components(); }
+
+  int size(ConstRefT x) noexcept { return uf_.size(id(x)); };
+
+ private:
+  Hash hash_{};
+
+  std::vector<T> keys_;     // id -> key
+  std::vector<int> table_;  // slot -> id, -1 if empty
+  CompactUnionFind uf_;
+
+  std::size_t slot(ConstRefT x) const {
+    // Scramble first: std::hash of an integer is usually the identity.
+    std::uint64_t h = hash_(x) * 0x9e3779b97f4a7c15ULL;
+    return (h ^ h >> 32) & (table_.size() - 1);
+  }
+
+  // The id of x, interning it as a new singleton if unseen.
+  int id(ConstRefT x) {
+    std::size_t mask = table_.size() - 1;
+    std::size_t h = slot(x);
+    for (; table_[h] != -1; h = (h + 1) & mask) {
+      if (keys_[table_[h]] == x) {
+        return table_[h];
+      }
     }
 
-    if (parent_.at(x) != x) {
-      parent_.at(x) = find(parent_.at(x));
+    keys_.push_back(x);
+    table_[h] = uf_.add();
+    if (2 * keys_.size() > table_.size()) {
+      grow();
     }
-    return parent_.at(x);
+    return static_cast<int>(keys_.size()) - 1;
   }
 
-  bool connected(ConstRefT x, ConstRefT y) noexcept {
-    return find(x) == find(y);
+  void grow() {
+    table_.assign(2 * table_.size(), -1);
+    std::size_t mask = table_.size() - 1;
+    for (int i = 0; i < static_cast<int>(keys_.size()); ++i) {
+      std::size_t h = slot(keys_[i]);
+      while (table_[h] != -1) {
+        h = (h + 1) & mask;
+      }
+      table_[h] = i;
+    }
+  }
+};
+
+namespace dsu {
+
+// Abelian groups for WeightedUnionFind: operator(), identity<T>() and
+// inverse(a).
+
+// a + b; works for integers and ModNum alike.
+struct Additive {
+  template <typename T>
+  T operator()(const T& a, const T& b) const noexcept {
+    return a + b;
+  }
+
+  template <typename T>
+  T identity() const noexcept {
+    return 0;
+  }
+
+  template <typename T>
+  T inverse(const T& a) const noexcept {
+    return -a;
+  }
+};
+
+// a ^ b; with T = int and weights 0/1 this tracks parity (bipartiteness).
+struct Xor {
+  template <typename T>
+  T operator()(const T& a, const T& b) const noexcept {
+    return a ^ b;
+  }
+
+  template <typename T>
+  T identity() const noexcept {
+    return 0;
+  }
+
+  template <typename T>
+  T inverse(const T& a) const noexcept {
+    return a;
+  }
+};
+
+};  // namespace dsu
+
+// UnionFind with a potential p(x) per element, known up to a shift per set.
+// Each element stores its offset from its parent, p(x) - p(parent), which
+// find() folds up along the way while halving the path.
+template <typename T = long long, typename Group = dsu::Additive>
+class WeightedUnionFind {
+ public:
+  WeightedUnionFind(int n)
+      : components_(n), data_(n, -1), diff_(n, op_.template identity<T>()) {}
+
+  int find(int x) noexcept { return walk(x).first; }
+
+  bool connected(int x, int y) noexcept { return find(x) == find(y); }
+
+  // p(y) - p(x); x and y must be connected.
+  T diff(int x, int y) noexcept {
+    return op_(walk(y).second, op_.inverse(walk(x).second));
   }
 
-  void unite(ConstRefT x, ConstRefT y) noexcept {
-    ConstRefT rootX = find(x);
-    ConstRefT rootY = find(x);
+  // Records p(y) - p(x) = w. Returns false, and changes nothing, if that
+  // contradicts what is already known.
+  bool unite(int x, int y, T w) noexcept {
+    auto [rootX, wx] = walk(x);
+    auto [rootY, wy] = walk(y);
+    T offset = op_(op_(w, wx), op_.inverse(wy));  // p(rootY) - p(rootX)
+
     if (rootX == rootY) {
-      return;
+      return offset == op_.template identity<T>();
     }
 
     --components_;
-    if (rank_[rootX] < rank_[rootY]) {
-      parent_[rootX] = rootY;
-      size_[rootY] += std::exchange(size_[rootX], 0);
-      return;
+    if (data_[rootX] > data_[rootY]) {  // rootX has the smaller set
+      std::swap(rootX, rootY);
+      offset = op_.inverse(offset);
     }
-
-    if (rank_[rootX] == rank_[rootY]) {
-      ++rank_[rootX];
-    }
-    parent_[rootY] = rootX;
-    size_[rootX] += std::exchange(size_[rootY], 0);
+    data_[rootX] += data_[rootY];
+    data_[rootY] = rootX;
+    diff_[rootY] = offset;
+    return true;
   }
 
   int components() const noexcept { return components_; }
 
-  int size(ConstRefT x) noexcept { return size_[find(x)]; };
+  int size(int x) noexcept { return -data_[find(x)]; }
 
  private:
   int components_;
 
-  std::unordered_map<T, T, Hash> parent_;
-  std::unordered_map<T, int, Hash> rank_;
-  std::unordered_map<T, int, Hash> size_;
+  const Group op_{};
+
+  std::vector<int> data_;  // parent, or minus the size at a root
+  std::vector<T> diff_;    // p(x) - p(parent)
+
+  // The root of x and p(x) - p(root).
+  std::pair<int, T> walk(int x) noexcept {
+    T sum = op_.template identity<T>();
+    while (data_[x] >= 0) {
+      int p = data_[x];
+      if (data_[p] >= 0) {  // path halving, x skips p
+        diff_[x] = op_(diff_[x], diff_[p]);
+        data_[x] = data_[p];
+      }
+      sum = op_(sum, diff_[x]);
+      x = data_[x];
+    }
+    return {x, sum};
+  }
 };
@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace wavelet {
+
+// Bits with O(1) rank: one 64-bit word per 64 bits, plus the number of ones
+// before each word.
+class BitVector {
+ public:
+  BitVector(int n = 0) : words_(n / 64 + 1, 0), before_(n / 64 + 1, 0) {}
+
+  void set(int i) { words_[i >> 6] |= 1ULL << (i & 63); }
+
+  bool get(int i) const { return words_[i >> 6] >> (i & 63) & 1; }
+
+  // Call once after the last set().
+  void build() {
+    for (std::size_t w = 1; w < words_.size(); ++w) {
+      before_[w] = before_[w - 1] + std::popcount(words_[w - 1]);
+    }
+  }
+
+  // Number of ones (zeros) in [0, i).
+  int rank1(int i) const {
+    std::uint64_t below = words_[i >> 6] & ((1ULL << (i & 63)) - 1);
+    return before_[i >> 6] + std::popcount(below);
+  }
+
+  int rank0(int i) const { return i - rank1(i); }
+
+ private:
+  std::vector<std::uint64_t> words_;
+  std::vector<std::uint32_t> before_;
+};
+
+};  // namespace wavelet
+
+// Wavelet matrix over non-negative values: one bitvector per value bit, from
+// the highest down, each level stably sorting the sequence by that bit (zeros
+// first). Every query walks the levels once, O(log sigma), and the whole
+// thing takes about n log sigma bits. Positions are inclusive [l, r] and k is
+// 1-based, as in SegmentTree::kthElement.
+template <typename T = long long>
+class WaveletMatrix {
+ public:
+  WaveletMatrix(std::vector<T> data) : n_(data.size()) {
+    T top = data.empty() ? 0 : *std::max_element(data.begin(), data.end());
+    bits_ = std::max(1, width(top));
+    levels_.assign(bits_, wavelet::BitVector(n_));
+    zeros_.assign(bits_, 0);
+
+    std::vector<T> next(n_);
+    for (int h = 0; h < bits_; ++h) {
+      int b = bits_ - 1 - h, z = 0;
+      for (int i = 0; i < n_; ++i) {
+        if (data[i] >> b & 1) {
+          levels_[h].set(i);
+        } else {
+          next[z++] = data[i];
+        }
+      }
+      levels_[h].build();
+      zeros_[h] = z;
+      for (int i = 0; i < n_; ++i) {
+        if (data[i] >> b & 1) {
+          next[z++] = data[i];
+        }
+      }
+      data.swap(next);
+    }
+  }
+
+  T access(int i) const {
+    T value = 0;
+    for (int h = 0; h < bits_; ++h) {
+      bool bit = levels_[h].get(i);
+      value = value << 1 | bit;
+      i = bit ? zeros_[h] + levels_[h].rank1(i) : levels_[h].rank0(i);
+    }
+    return value;
+  }
+
+  // k-th smallest value in a[l..r], or -1 if k is out of range.
+  T kthSmallest(int l, int r, int k) const {
+    if (k < 1 || k > r - l + 1) {
+      return -1;
+    }
+    ++r, --k;  // half-open and 0-based from here on
+    T value = 0;
+    for (int h = 0; h < bits_; ++h) {
+      const auto& level = levels_[h];
+      int zl = level.rank0(l), zr = level.rank0(r);
+      if (k < zr - zl) {
+        value <<= 1;
+        l = zl, r = zr;
+      } else {
+        value = value << 1 | 1;
+        k -= zr - zl;
+        l = zeros_[h] + (l - zl), r = zeros_[h] + (r - zr);
+      }
+    }
+    return value;
+  }
+
+  T kthLargest(int l, int r, int k) const {
+    return kthSmallest(l, r, r - l + 2 - k);
+  }
+
+  // Number of values below x in a[l..r].
+  int countLess(int l, int r, T x) const {
+    if (x <= 0) {
+      return 0;
+    }
+    if (width(x) > bits_) {
+      return r - l + 1;
+    }
+    ++r;
+    int count = 0;
+    for (int h = 0; h < bits_; ++h) {
+      const auto& level = levels_[h];
+      int zl = level.rank0(l), zr = level.rank0(r);
+      if (x >> (bits_ - 1 - h) & 1) {
+        count += zr - zl;
+        l = zeros_[h] + (l - zl), r = zeros_[h] + (r - zr);
+      } else {
+        l = zl, r = zr;
+      }
+    }
+    return count;
+  }
+
+  // Number of values in [lower, upper) in a[l..r].
+  int rangeFreq(int l, int r, T lower, T upper) const {
+    return lower >= upper ? 0 : countLess(l, r, upper) - countLess(l, r, lower);
+  }
+
+  // Largest value below x in a[l..r], or -1 if there is none.
+  T prevValue(int l, int r, T x) const {
+    int c = countLess(l, r, x);
+    return c == 0 ? -1 : kthSmallest(l, r, c);
+  }
+
+  // Smallest value >= x in a[l..r], or -1 if there is none.
+  T nextValue(int l, int r, T x) const {
+    int c = countLess(l, r, x);
+    return c == r - l + 1 ? -1 : kthSmallest(l, r, c + 1);
+  }
+
+ private:
+  int n_;
+  int bits_;  // bits per value
+  std::vector<wavelet::BitVector> levels_;
+  std::vector<int> zeros_;  // zeros on each level, where its ones start
+
+  static int width(T x) {
+    return static_cast<int>(std::bit_width(static_cast<std::uint64_t>(x)));
+  }
+};